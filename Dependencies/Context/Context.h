@@ -0,0 +1,554 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+#include <GLFW/glfw3.h>
+#include <GLExt.h>
+#include <FrameBenchmark.h>
+#include <CpuProfiler.h>
+#include <GpuProfiler.h>
+#include <GLInterceptor.h>
+
+// headless rendering needs EGL (Mesa surfaceless / llvmpipe on GPU-less machines).
+// Define LEARNOPENGL_HEADLESS_EGL and link against libEGL to enable it.
+#ifdef LEARNOPENGL_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Settings used to create a Context
+/// </summary>
+struct ContextSettings
+{
+	unsigned int width = 800;
+	unsigned int height = 600;
+	const char* title = "LearnOpenGL";
+	// render offscreen into a framebuffer object instead of a window
+	bool headless = false;
+	// number of frames rendered before a headless run closes
+	unsigned int frames = 1;
+	// optional .ppm file where the last headless frame is written
+	std::string output;
+	// benchmark: JSON report written after warmup + frames frames, empty when not benchmarking
+	std::string benchmark;
+	unsigned int warmup = 10;
+	// name of the sample in the benchmark report, the executable name by default
+	std::string name;
+	// GPU profiling: Chrome trace of the GpuScopes written at exit, empty when not profiling
+	std::string profile;
+	// GL call interception: JSON report of the calls per entry point and per frame, empty when off
+	std::string glCalls;
+};
+
+class Context
+{
+public:
+	/// <summary>
+	/// Reads the headless and benchmark options from the command line:
+	/// --headless, --frames N, --output file.ppm, --benchmark report.json ("-" prints it), --warmup N,
+	/// --profile trace.json and --gl-calls report.json ("-" prints it). A benchmark measures --frames frames (100 unless given) after the warm-up ones
+	/// </summary>
+	/// <param name="argc">Argument count from main</param>
+	/// <param name="argv">Arguments from main</param>
+	/// <param name="settings">Default settings of the sample</param>
+	static ContextSettings ParseArgs(int argc, char** argv, ContextSettings settings)
+	{
+		if (settings.name.empty() && argc > 0)
+		{
+			// executable name without directory nor extension
+			std::string path = argv[0];
+			size_t slash = path.find_last_of("/\\");
+			settings.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+			settings.name = settings.name.substr(0, settings.name.find('.'));
+		}
+		bool framesGiven = false;
+		for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--headless") == 0)
+			{
+				settings.headless = true;
+			}
+			else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			{
+				settings.frames = (unsigned int)strtoul(argv[++i], NULL, 10);
+				framesGiven = true;
+			}
+			else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			{
+				settings.output = argv[++i];
+			}
+			else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+			{
+				settings.benchmark = argv[++i];
+			}
+			else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+			{
+				settings.warmup = (unsigned int)strtoul(argv[++i], NULL, 10);
+			}
+			else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			{
+				settings.profile = argv[++i];
+			}
+			else if (strcmp(argv[i], "--gl-calls") == 0 && i + 1 < argc)
+			{
+				settings.glCalls = argv[++i];
+			}
+		}
+		if (!settings.benchmark.empty() && !framesGiven)
+		{
+			settings.frames = 100;
+		}
+		return settings;
+	}
+
+	/// <summary>
+	/// Creates a window (or an offscreen framebuffer when headless) with an OpenGL 3.3 core context and loads GLAD
+	/// </summary>
+	/// <param name="settings">Context settings</param>
+	Context(const ContextSettings& settings)
+		: settings(settings)
+	{
+		valid = settings.headless ? initHeadless() : initWindow();
+		if (!valid)
+		{
+			return;
+		}
+
+		// set OpenGL Viewport size
+		glViewport(0, 0, settings.width, settings.height);
+
+		if (!settings.benchmark.empty())
+		{
+			if (window)
+			{
+				// measure the frames, not the display refresh
+				glfwSwapInterval(0);
+			}
+			FrameBenchmark::HookDrawCalls();
+			benchmark.reset(new FrameBenchmark(settings.warmup, settings.frames));
+		}
+		if (!settings.profile.empty())
+		{
+			// CPU scopes (shader compilation, texture decoding and uploads) and GpuScopes are timed from now on
+			CpuProfiler::Start();
+			PROFILE_THREAD("main");
+			profiler.reset(new GpuProfiler());
+		}
+		if (!settings.glCalls.empty())
+		{
+			// after the draw call counters of the benchmark, which the interceptor then calls
+			GLInterceptor::Install();
+		}
+		startTime = std::chrono::steady_clock::now();
+	}
+
+	~Context()
+	{
+		terminate();
+	}
+
+	Context(const Context&) = delete;
+	Context& operator=(const Context&) = delete;
+
+	/// <summary>
+	/// Returns true if the window (or offscreen target) and the context were created
+	/// </summary>
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	/// <summary>
+	/// Returns true if rendering offscreen
+	/// </summary>
+	bool isHeadless() const
+	{
+		return settings.headless;
+	}
+
+	/// <summary>
+	/// Returns the GLFW window, NULL when headless
+	/// </summary>
+	GLFWwindow* getWindow() const
+	{
+		return window;
+	}
+
+	/// <summary>
+	/// Returns the number of frames presented so far
+	/// </summary>
+	unsigned int getFrameCount() const
+	{
+		return frameCount;
+	}
+
+	/// <summary>
+	/// Looks up an OpenGL entry point with the loader of the current context
+	/// </summary>
+	/// <param name="name">Name of the function</param>
+	static void* GetProcAddress(const char* name)
+	{
+#ifdef LEARNOPENGL_HEADLESS_EGL
+		if (eglGetCurrentContext() != EGL_NO_CONTEXT)
+		{
+			return (void*)eglGetProcAddress(name);
+		}
+#endif
+		return (void*)glfwGetProcAddress(name);
+	}
+
+	/// <summary>
+	/// Sets the window resize callback, ignored when headless
+	/// </summary>
+	void setFramebufferSizeCallback(GLFWframebuffersizefun callback)
+	{
+		if (window)
+		{
+			glfwSetFramebufferSizeCallback(window, callback);
+		}
+	}
+
+	/// <summary>
+	/// Sets the keyboard input callback, ignored when headless
+	/// </summary>
+	void setKeyCallback(GLFWkeyfun callback)
+	{
+		if (window)
+		{
+			glfwSetKeyCallback(window, callback);
+		}
+	}
+
+	/// <summary>
+	/// Returns true when the render loop should stop: the window was closed,
+	/// the requested number of headless frames was rendered or the benchmark is over
+	/// </summary>
+	bool shouldClose() const
+	{
+		if (benchmark && benchmark->isDone())
+		{
+			return true;
+		}
+		if (settings.headless)
+		{
+			return !benchmark && frameCount >= settings.frames;
+		}
+		return glfwWindowShouldClose(window);
+	}
+
+	/// <summary>
+	/// Presents the frame
+	/// </summary>
+	void swapBuffers()
+	{
+		PROFILE_SCOPE("swap");
+		PROFILE_FRAME();
+		frameCount++;
+		if (profiler)
+		{
+			profiler->frame();
+		}
+		if (benchmark)
+		{
+			benchmark->endFrame();
+		}
+		GLInterceptor::Frame();
+		if (!settings.headless)
+		{
+			glfwSwapBuffers(window);
+			return;
+		}
+
+		glFlush();
+		if (frameCount == (benchmark ? benchmark->getFrameTotal() : settings.frames) && !settings.output.empty())
+		{
+			writeFrame(settings.output);
+		}
+	}
+
+	/// <summary>
+	/// Polls IO events (keys pressed/released, mouse moved etc.), nothing to do when headless
+	/// </summary>
+	void pollEvents()
+	{
+		PROFILE_SCOPE("poll events");
+		if (!settings.headless)
+		{
+			glfwPollEvents();
+		}
+	}
+
+	/// <summary>
+	/// Returns the time in seconds used to animate the scene.
+	/// Headless runs and benchmarks advance a fixed 60Hz clock so the frames are reproducible.
+	/// </summary>
+	double getTime() const
+	{
+		if (settings.headless || benchmark)
+		{
+			return frameCount / 60.0;
+		}
+		return glfwGetTime();
+	}
+
+	/// <summary>
+	/// Reads back the color buffer as tightly packed RGB rows, bottom row first
+	/// </summary>
+	/// <param name="pixels">Destination buffer</param>
+	void readPixels(std::vector<unsigned char>& pixels) const
+	{
+		pixels.resize((size_t)settings.width * settings.height * 3);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, settings.width, settings.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	}
+
+	/// <summary>
+	/// Releases the window or the offscreen context, prints the headless throughput
+	/// and writes the benchmark report, the CPU/GPU profile and the GL call report
+	/// </summary>
+	void terminate()
+	{
+		if (!valid)
+		{
+			return;
+		}
+		valid = false;
+
+		if (benchmark)
+		{
+			benchmark->report(settings.benchmark, settings.name, settings.width, settings.height,
+				(const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+			benchmark.reset();
+		}
+		if (profiler)
+		{
+			CpuProfiler::Stop();
+			profiler->flush();
+			CpuProfiler::Print();
+			profiler->print();
+			writeProfile(settings.profile);
+			profiler.reset();
+		}
+		if (!settings.glCalls.empty())
+		{
+			GLInterceptor::Print();
+			GLInterceptor::WriteReport(settings.glCalls, settings.name);
+		}
+
+		if (!settings.headless)
+		{
+			// glfw: terminate, clearing all previously allocated GLFW resources.
+			glfwTerminate();
+			return;
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		std::cout << "LOG::CONTEXT::HEADLESS_FRAMES " << frameCount << " in " << seconds * 1000.0 << " ms ("
+			<< (seconds > 0.0 ? frameCount / seconds : 0.0) << " fps)" << std::endl;
+
+		releaseHeadless();
+	}
+
+private:
+	ContextSettings settings;
+	GLFWwindow* window = NULL;
+	bool valid = false;
+	unsigned int frameCount = 0;
+	std::chrono::steady_clock::time_point startTime;
+	std::unique_ptr<FrameBenchmark> benchmark;
+	std::unique_ptr<GpuProfiler> profiler;
+
+	// offscreen target: color + depth/stencil renderbuffers
+	GLuint FBO = 0;
+	GLuint RBO[2] = { 0, 0 };
+
+#ifdef LEARNOPENGL_HEADLESS_EGL
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext eglContext = EGL_NO_CONTEXT;
+#endif
+
+	// deletes the offscreen target, then the EGL context and display
+	void releaseHeadless()
+	{
+		if (FBO)
+		{
+			glDeleteFramebuffers(1, &FBO);
+			glDeleteRenderbuffers(2, RBO);
+			FBO = 0;
+		}
+#ifdef LEARNOPENGL_HEADLESS_EGL
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, eglContext);
+		eglTerminate(display);
+		eglContext = EGL_NO_CONTEXT;
+		display = EGL_NO_DISPLAY;
+#endif
+	}
+
+	bool initWindow()
+	{
+		// init glfw
+		if (!glfwInit())
+		{
+			std::cerr << "Could not load GLFW" << std::endl;
+			return false;
+		}
+
+		// glfw settings
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+		// create window and context
+		window = glfwCreateWindow(settings.width, settings.height, settings.title, NULL, NULL);
+		if (window == NULL)
+		{
+			std::cout << "Failed to create GLFW window" << std::endl;
+			glfwTerminate();
+			return false;
+		}
+		glfwMakeContextCurrent(window);
+
+		// load GLAD
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			glfwTerminate();
+			return false;
+		}
+		GLExt::Load((GLADloadproc)glfwGetProcAddress);
+		return true;
+	}
+
+	bool initHeadless()
+	{
+#ifdef LEARNOPENGL_HEADLESS_EGL
+		// prefer the surfaceless platform: it needs neither a display server nor a GPU
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+		{
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+		if (display == EGL_NO_DISPLAY)
+		{
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		EGLint major, minor;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+		{
+			std::cout << "ERROR::CONTEXT::EGL_INITIALIZATION_FAILED" << std::endl;
+			return false;
+		}
+
+		const EGLint configAttribs[] = {
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_NONE
+		};
+		EGLConfig config = NULL;
+		EGLint numConfigs = 0;
+		eglChooseConfig(display, configAttribs, &config, 1, &numConfigs);
+
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		eglBindAPI(EGL_OPENGL_API);
+		eglContext = eglCreateContext(display, numConfigs ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+		if (eglContext == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+		{
+			std::cout << "ERROR::CONTEXT::EGL_CONTEXT_CREATION_FAILED" << std::endl;
+			eglTerminate(display);
+			return false;
+		}
+
+		// load GLAD
+		if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			releaseHeadless();
+			return false;
+		}
+		GLExt::Load((GLADloadproc)eglGetProcAddress);
+
+		// the framebuffer object replaces the window's default framebuffer
+		glGenFramebuffers(1, &FBO);
+		glGenRenderbuffers(2, RBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, RBO[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, settings.width, settings.height);
+		glBindRenderbuffer(GL_RENDERBUFFER, RBO[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, settings.width, settings.height);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, RBO[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO[1]);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR::CONTEXT::FRAMEBUFFER_INCOMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			releaseHeadless();
+			return false;
+		}
+
+		std::cout << "LOG::CONTEXT::HEADLESS " << glGetString(GL_RENDERER) << std::endl;
+		return true;
+#else
+		std::cout << "ERROR::CONTEXT::HEADLESS_NOT_AVAILABLE (build with LEARNOPENGL_HEADLESS_EGL)" << std::endl;
+		return false;
+#endif
+	}
+
+	void writeFrame(const std::string& path) const
+	{
+		std::vector<unsigned char> pixels;
+		readPixels(pixels);
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			std::cout << "ERROR::CONTEXT::FRAME_NOT_WRITTEN " << path << std::endl;
+			return;
+		}
+		fprintf(file, "P6\n%u %u\n255\n", settings.width, settings.height);
+		// OpenGL rows start at the bottom, ppm rows at the top
+		size_t rowSize = (size_t)settings.width * 3;
+		for (unsigned int y = settings.height; y > 0; y--)
+		{
+			fwrite(pixels.data() + (y - 1) * rowSize, 1, rowSize, file);
+		}
+		fclose(file);
+	}
+
+	// one Chrome trace with the CPU threads and the GPU track on the same time line
+	void writeProfile(const std::string& path) const
+	{
+		FILE* file = fopen(path.c_str(), "w");
+		if (!file)
+		{
+			std::cout << "ERROR::CONTEXT::PROFILE_NOT_WRITTEN " << path << std::endl;
+			return;
+		}
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}", settings.name.c_str());
+		size_t count = CpuProfiler::WriteEvents(file);
+		profiler->writeEvents(file, CpuProfiler::GetStartTime());
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		std::cout << "LOG::CONTEXT::PROFILE " << path << " " << count << " CPU events" << std::endl;
+	}
+};
+
+#endif // !CONTEXT_H
@@ -0,0 +1,282 @@
+#ifndef FRAME_BENCHMARK_H
+#define FRAME_BENCHMARK_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Measures a fixed number of frames after a warm-up: the CPU time of every frame (from the end
+/// of the previous one to the swap), the time until the GPU is done with it (glFinish) and its
+/// draw calls, then reports mean, p50, p95, p99 and max as JSON so runs of different builds compare.
+/// The draw calls are counted by wrapping the glad entry points, so the samples need no change.
+/// </summary>
+class FrameBenchmark
+{
+public:
+	/// <summary>
+	/// Percentiles of one measure over the measured frames
+	/// </summary>
+	struct Summary
+	{
+		double mean = 0.0;
+		double min = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	/// <summary>
+	/// Prepares a run, frames are timed from now on
+	/// </summary>
+	/// <param name="warmup">Frames rendered before measuring (shader compilation, texture uploads, caches)</param>
+	/// <param name="frames">Frames measured</param>
+	FrameBenchmark(unsigned int warmup = 0, unsigned int frames = 0)
+		: warmup(warmup), frames(frames)
+	{
+		cpuTimes.reserve(frames);
+		gpuTimes.reserve(frames);
+		drawCounts.reserve(frames);
+		frameStart = std::chrono::steady_clock::now();
+	}
+
+	/// <summary>
+	/// Ends the current frame before it is presented: waits for the GPU and records the frame once warm
+	/// </summary>
+	void endFrame()
+	{
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		glFinish();
+		std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+		uint64_t draws = DrawCalls;
+		DrawCalls = 0;
+
+		if (++frameCount > warmup && cpuTimes.size() < frames)
+		{
+			cpuTimes.push_back(std::chrono::duration<double, std::milli>(submitted - frameStart).count());
+			gpuTimes.push_back(std::chrono::duration<double, std::milli>(finished - frameStart).count());
+			drawCounts.push_back((double)draws);
+		}
+		// the wait is part of this frame, the next starts now
+		frameStart = finished;
+	}
+
+	/// <summary>
+	/// Returns true once every measured frame was rendered
+	/// </summary>
+	bool isDone() const
+	{
+		return frameCount >= warmup + frames;
+	}
+
+	/// <summary>
+	/// Returns the number of frames of the whole run, warm-up included
+	/// </summary>
+	unsigned int getFrameTotal() const
+	{
+		return warmup + frames;
+	}
+
+	/// <summary>
+	/// Writes the report as JSON and prints a summary
+	/// </summary>
+	/// <param name="path">JSON file, "-" prints it instead</param>
+	/// <param name="scene">Name of the sample</param>
+	/// <param name="width">Framebuffer width</param>
+	/// <param name="height">Framebuffer height</param>
+	/// <param name="renderer">GL_RENDERER of the context</param>
+	/// <param name="version">GL_VERSION of the context</param>
+	/// <returns>False if the file couldn't be written</returns>
+	bool report(const std::string& path, const std::string& scene, unsigned int width, unsigned int height,
+		const std::string& renderer, const std::string& version) const
+	{
+		Summary cpu = Summarize(cpuTimes);
+		Summary gpu = Summarize(gpuTimes);
+		Summary draws = Summarize(drawCounts);
+		std::cout << "LOG::BENCHMARK::" << scene << " " << cpuTimes.size() << " frames, cpu p50 " << cpu.p50 << " ms p99 " << cpu.p99
+			<< " ms, gpu p50 " << gpu.p50 << " ms p99 " << gpu.p99 << " ms, " << draws.mean << " draw calls per frame" << std::endl;
+
+		FILE* file = path == "-" ? stdout : fopen(path.c_str(), "w");
+		if (!file)
+		{
+			std::cout << "ERROR::BENCHMARK::REPORT_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		fprintf(file, "{\n");
+		fprintf(file, "  \"scene\": \"%s\",\n", Escape(scene).c_str());
+		fprintf(file, "  \"renderer\": \"%s\",\n", Escape(renderer).c_str());
+		fprintf(file, "  \"version\": \"%s\",\n", Escape(version).c_str());
+		fprintf(file, "  \"width\": %u,\n", width);
+		fprintf(file, "  \"height\": %u,\n", height);
+		fprintf(file, "  \"warmup_frames\": %u,\n", warmup);
+		fprintf(file, "  \"frames\": %zu,\n", cpuTimes.size());
+		WriteSummary(file, "cpu_ms", cpu, false);
+		WriteSummary(file, "gpu_ms", gpu, false);
+		WriteSummary(file, "draw_calls", draws, true);
+		fprintf(file, "}\n");
+		if (file != stdout)
+		{
+			fclose(file);
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Sorts the values and picks the percentiles (nearest rank)
+	/// </summary>
+	static Summary Summarize(std::vector<double> values)
+	{
+		Summary summary;
+		if (values.empty())
+		{
+			return summary;
+		}
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (double value : values)
+		{
+			sum += value;
+		}
+		auto percentile = [&values](double p)
+		{
+			size_t rank = (size_t)std::ceil(p / 100.0 * values.size());
+			return values[std::min(std::max(rank, (size_t)1), values.size()) - 1];
+		};
+		summary.mean = sum / values.size();
+		summary.min = values.front();
+		summary.p50 = percentile(50.0);
+		summary.p95 = percentile(95.0);
+		summary.p99 = percentile(99.0);
+		summary.max = values.back();
+		return summary;
+	}
+
+	/// <summary>
+	/// Counts the draw calls from now on: the glad draw entry points are replaced by wrappers
+	/// calling the driver. Call it once, after loading glad
+	/// </summary>
+	static void HookDrawCalls()
+	{
+		if (DrawArrays)
+		{
+			return;
+		}
+		DrawArrays = glad_glDrawArrays;
+		glad_glDrawArrays = CountDrawArrays;
+		DrawElements = glad_glDrawElements;
+		glad_glDrawElements = CountDrawElements;
+		DrawRangeElements = glad_glDrawRangeElements;
+		glad_glDrawRangeElements = CountDrawRangeElements;
+		DrawArraysInstanced = glad_glDrawArraysInstanced;
+		glad_glDrawArraysInstanced = CountDrawArraysInstanced;
+		DrawElementsInstanced = glad_glDrawElementsInstanced;
+		glad_glDrawElementsInstanced = CountDrawElementsInstanced;
+		DrawElementsBaseVertex = glad_glDrawElementsBaseVertex;
+		glad_glDrawElementsBaseVertex = CountDrawElementsBaseVertex;
+		MultiDrawArrays = glad_glMultiDrawArrays;
+		glad_glMultiDrawArrays = CountMultiDrawArrays;
+		MultiDrawElements = glad_glMultiDrawElements;
+		glad_glMultiDrawElements = CountMultiDrawElements;
+	}
+
+private:
+	unsigned int warmup;
+	unsigned int frames;
+	unsigned int frameCount = 0;
+	std::chrono::steady_clock::time_point frameStart;
+	std::vector<double> cpuTimes;
+	std::vector<double> gpuTimes;
+	std::vector<double> drawCounts;
+
+	// draw calls since the last frame, the samples draw from the GL thread only
+	inline static uint64_t DrawCalls = 0;
+
+	// driver entry points behind the wrappers
+	inline static PFNGLDRAWARRAYSPROC DrawArrays = NULL;
+	inline static PFNGLDRAWELEMENTSPROC DrawElements = NULL;
+	inline static PFNGLDRAWRANGEELEMENTSPROC DrawRangeElements = NULL;
+	inline static PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced = NULL;
+	inline static PFNGLDRAWELEMENTSINSTANCEDPROC DrawElementsInstanced = NULL;
+	inline static PFNGLDRAWELEMENTSBASEVERTEXPROC DrawElementsBaseVertex = NULL;
+	inline static PFNGLMULTIDRAWARRAYSPROC MultiDrawArrays = NULL;
+	inline static PFNGLMULTIDRAWELEMENTSPROC MultiDrawElements = NULL;
+
+	static void APIENTRY CountDrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		DrawCalls++;
+		DrawArrays(mode, first, count);
+	}
+
+	static void APIENTRY CountDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		DrawCalls++;
+		DrawElements(mode, count, type, indices);
+	}
+
+	static void APIENTRY CountDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices)
+	{
+		DrawCalls++;
+		DrawRangeElements(mode, start, end, count, type, indices);
+	}
+
+	static void APIENTRY CountDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+	{
+		DrawCalls++;
+		DrawArraysInstanced(mode, first, count, instances);
+	}
+
+	static void APIENTRY CountDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances)
+	{
+		DrawCalls++;
+		DrawElementsInstanced(mode, count, type, indices, instances);
+	}
+
+	static void APIENTRY CountDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex)
+	{
+		DrawCalls++;
+		DrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+	}
+
+	// a multi draw is one call from the application, the driver sees drawCount draws
+	static void APIENTRY CountMultiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawCount)
+	{
+		DrawCalls++;
+		MultiDrawArrays(mode, first, count, drawCount);
+	}
+
+	static void APIENTRY CountMultiDrawElements(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawCount)
+	{
+		DrawCalls++;
+		MultiDrawElements(mode, count, type, indices, drawCount);
+	}
+
+	static std::string Escape(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				escaped += '\\';
+			}
+			escaped += (unsigned char)c < 0x20 ? ' ' : c;
+		}
+		return escaped;
+	}
+
+	static void WriteSummary(FILE* file, const char* name, const Summary& summary, bool last)
+	{
+		fprintf(file, "  \"%s\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+			name, summary.mean, summary.min, summary.p50, summary.p95, summary.p99, summary.max, last ? "" : ",");
+	}
+};
+
+#endif // !FRAME_BENCHMARK_H
@@ -0,0 +1,182 @@
+#ifndef GLEXT_H
+#define GLEXT_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+// glad is generated for OpenGL 3.3 core without extensions: the newer entry points
+// used by the samples are declared and loaded here.
+
+// ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// ARB_buffer_storage (core in 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// ARB_texture_storage (core in 4.2)
+#ifndef GL_TEXTURE_IMMUTABLE_FORMAT
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#endif
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+
+// ARB_copy_image (core in 4.3)
+typedef void (APIENTRYP PFNGLCOPYIMAGESUBDATAPROC)(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+	GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth);
+
+// NVX_gpu_memory_info and ATI_meminfo, sizes in KB
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_VBO_FREE_MEMORY_ATI 0x87FB
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// ARB_bindless_texture
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+// EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// EXT_texture_sRGB, the S3TC formats decoded from sRGB when sampled
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace GLExt
+{
+	inline PFNGLGETPROGRAMBINARYPROC GetProgramBinary = NULL;
+	inline PFNGLPROGRAMBINARYPROC ProgramBinary = NULL;
+	inline PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = NULL;
+	inline PFNGLMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreads = NULL;
+	inline PFNGLBUFFERSTORAGEPROC BufferStorage = NULL;
+	inline PFNGLTEXSTORAGE2DPROC TexStorage2D = NULL;
+	inline PFNGLTEXSTORAGE3DPROC TexStorage3D = NULL;
+	inline PFNGLCOPYIMAGESUBDATAPROC CopyImageSubData = NULL;
+	inline PFNGLGETTEXTUREHANDLEARBPROC GetTextureHandle = NULL;
+	inline PFNGLMAKETEXTUREHANDLERESIDENTARBPROC MakeTextureHandleResident = NULL;
+	inline PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC MakeTextureHandleNonResident = NULL;
+
+	// GL_COMPLETION_STATUS_KHR can be polled without blocking
+	inline bool parallelShaderCompile = false;
+
+	inline std::unordered_set<std::string> extensions;
+	inline int versionMajor = 0;
+	inline int versionMinor = 0;
+
+	/// <summary>
+	/// Returns true if the current context exposes the extension
+	/// </summary>
+	/// <param name="name">Extension name, e.g. "GL_ARB_buffer_storage"</param>
+	inline bool HasExtension(const char* name)
+	{
+		return extensions.count(name) != 0;
+	}
+
+	/// <summary>
+	/// Returns true if the context version is at least major.minor
+	/// </summary>
+	inline bool HasVersion(int major, int minor)
+	{
+		return versionMajor > major || (versionMajor == major && versionMinor >= minor);
+	}
+
+	/// <summary>
+	/// Loads the extension entry points, call it after gladLoadGLLoader with the same loader
+	/// </summary>
+	/// <param name="load">Loader of the current context</param>
+	inline void Load(GLADloadproc load)
+	{
+		glGetIntegerv(GL_MAJOR_VERSION, &versionMajor);
+		glGetIntegerv(GL_MINOR_VERSION, &versionMinor);
+
+		extensions.clear();
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++)
+		{
+			extensions.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+		}
+
+		if (HasVersion(4, 1) || HasExtension("GL_ARB_get_program_binary"))
+		{
+			GetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+			ProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+			ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+		}
+
+		if (HasExtension("GL_KHR_parallel_shader_compile"))
+		{
+			MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+		}
+		else if (HasExtension("GL_ARB_parallel_shader_compile"))
+		{
+			MaxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+		}
+		parallelShaderCompile = MaxShaderCompilerThreads != NULL;
+		if (parallelShaderCompile)
+		{
+			// let the driver pick as many compiler threads as it likes
+			MaxShaderCompilerThreads(0xFFFFFFFF);
+		}
+
+		if (HasVersion(4, 4) || HasExtension("GL_ARB_buffer_storage"))
+		{
+			BufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+		}
+
+		if (HasVersion(4, 2) || HasExtension("GL_ARB_texture_storage"))
+		{
+			TexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+			TexStorage3D = (PFNGLTEXSTORAGE3DPROC)load("glTexStorage3D");
+		}
+
+		if (HasVersion(4, 3) || HasExtension("GL_ARB_copy_image"))
+		{
+			CopyImageSubData = (PFNGLCOPYIMAGESUBDATAPROC)load("glCopyImageSubData");
+		}
+
+		if (HasExtension("GL_ARB_bindless_texture"))
+		{
+			GetTextureHandle = (PFNGLGETTEXTUREHANDLEARBPROC)load("glGetTextureHandleARB");
+			MakeTextureHandleResident = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)load("glMakeTextureHandleResidentARB");
+			MakeTextureHandleNonResident = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)load("glMakeTextureHandleNonResidentARB");
+		}
+	}
+}
+
+#endif // !GLEXT_H
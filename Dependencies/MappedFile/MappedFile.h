@@ -0,0 +1,159 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// <summary>
+/// Read-only memory mapping of a whole file, the content is never copied
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	/// <summary>
+	/// Maps the file, check isOpen() for errors
+	/// </summary>
+	/// <param name="path">File path</param>
+	explicit MappedFile(const char* path)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize))
+		{
+			size = (size_t)fileSize.QuadPart;
+			open = true;
+			if (size > 0)
+			{
+				HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mapping)
+				{
+					data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+					CloseHandle(mapping);
+				}
+				open = data != NULL;
+			}
+		}
+		CloseHandle(file);
+#else
+		int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0)
+		{
+			return;
+		}
+		struct stat info;
+		if (fstat(fd, &info) == 0)
+		{
+			size = (size_t)info.st_size;
+			open = true;
+			if (size > 0)
+			{
+				void* address = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				data = address == MAP_FAILED ? NULL : (const char*)address;
+				open = data != NULL;
+			}
+		}
+		::close(fd);
+#endif
+		if (!open)
+		{
+			size = 0;
+		}
+	}
+
+	~MappedFile()
+	{
+		unmap();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept
+		: data(other.data), size(other.size), open(other.open)
+	{
+		other.data = NULL;
+		other.size = 0;
+		other.open = false;
+	}
+
+	MappedFile& operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			unmap();
+			data = other.data;
+			size = other.size;
+			open = other.open;
+			other.data = NULL;
+			other.size = 0;
+			other.open = false;
+		}
+		return *this;
+	}
+
+	/// <summary>
+	/// Returns true if the file was opened (an empty file is open but has no data)
+	/// </summary>
+	bool isOpen() const
+	{
+		return open;
+	}
+
+	/// <summary>
+	/// Returns the content of the file, not null terminated
+	/// </summary>
+	const char* getData() const
+	{
+		return data ? data : "";
+	}
+
+	/// <summary>
+	/// Returns the size of the file in bytes
+	/// </summary>
+	size_t getSize() const
+	{
+		return size;
+	}
+
+private:
+	const char* data = NULL;
+	size_t size = 0;
+	bool open = false;
+
+	void unmap()
+	{
+		if (!data)
+		{
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap((void*)data, size);
+#endif
+		data = NULL;
+	}
+};
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,382 @@
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_PROFILER_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+/// <summary>
+/// Records timed scopes and counters of every thread into per-thread buffers, written as a Chrome trace.
+/// Recording takes no lock: a thread appends to its own fixed size buffer and publishes the count
+/// with a release store, the writer reads it with an acquire load; a full buffer drops events and counts them.
+/// Scopes are timed with RDTSC on x86 (steady_clock elsewhere), converted to microseconds against
+/// steady_clock over the whole recording. Instrument with the PROFILE_* macros below: they are
+/// compiled out unless LEARNOPENGL_PROFILING is defined, and cost a relaxed load when not recording.
+/// </summary>
+class CpuProfiler
+{
+public:
+	/// <summary>
+	/// Starts recording, clears what was recorded before. Call it before the threads record
+	/// </summary>
+	/// <param name="capacity">Events per thread, the next ones are dropped</param>
+	static void Start(size_t capacity = 1 << 16)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Capacity = std::max(capacity, (size_t)1);
+		for (std::unique_ptr<ThreadBuffer>& buffer : Buffers)
+		{
+			buffer->events.assign(Capacity, Event());
+			buffer->count.store(0, std::memory_order_relaxed);
+			buffer->dropped = 0;
+			buffer->lastFrame = 0;
+		}
+		StartTicks = Now();
+		StartTime = std::chrono::steady_clock::now();
+		Recording.store(true, std::memory_order_release);
+	}
+
+	/// <summary>
+	/// Stops recording, the events stay until the next Start()
+	/// </summary>
+	static void Stop()
+	{
+		if (Recording.exchange(false))
+		{
+			StopTicks = Now();
+			StopTime = std::chrono::steady_clock::now();
+		}
+	}
+
+	static bool IsRecording()
+	{
+		return Recording.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Returns the clock of the scopes: CPU ticks (RDTSC) or steady_clock nanoseconds
+	/// </summary>
+	static uint64_t Now()
+	{
+#ifdef CPU_PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	/// <summary>
+	/// Returns the time the trace is relative to
+	/// </summary>
+	static std::chrono::steady_clock::time_point GetStartTime()
+	{
+		return StartTime;
+	}
+
+	/// <summary>
+	/// Records a scope of the calling thread
+	/// </summary>
+	/// <param name="name">Name, a string that outlives the profiler (a literal)</param>
+	/// <param name="begin">Now() at the start of the scope</param>
+	/// <param name="end">Now() at its end</param>
+	static void Scope(const char* name, uint64_t begin, uint64_t end)
+	{
+		if (IsRecording())
+		{
+			Local().push(Event{ name, begin, end, 0.0, EventType::Scope });
+		}
+	}
+
+	/// <summary>
+	/// Records the value of a counter (bytes uploaded, pages resident...), drawn as a graph
+	/// </summary>
+	static void Counter(const char* name, double value)
+	{
+		if (IsRecording())
+		{
+			uint64_t now = Now();
+			Local().push(Event{ name, now, now, value, EventType::Counter });
+		}
+	}
+
+	/// <summary>
+	/// Records a "frame" scope from the previous call on this thread, once per frame
+	/// </summary>
+	static void Frame()
+	{
+		if (!IsRecording())
+		{
+			return;
+		}
+		ThreadBuffer& buffer = Local();
+		uint64_t now = Now();
+		buffer.push(Event{ "frame", buffer.lastFrame ? buffer.lastFrame : StartTicks, now, 0.0, EventType::Scope });
+		buffer.lastFrame = now;
+	}
+
+	/// <summary>
+	/// Names the calling thread in the trace. Costs nothing until the thread records an event
+	/// </summary>
+	static void SetThreadName(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		ThreadName() = name;
+		if (LocalBuffer())
+		{
+			LocalBuffer()->name = name;
+		}
+	}
+
+	/// <summary>
+	/// Writes the recorded events as Chrome trace events, each preceded by a comma:
+	/// the caller writes the enclosing array and its first element
+	/// </summary>
+	/// <returns>Number of events written</returns>
+	static size_t WriteEvents(FILE* file)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		double ticksPerMicrosecond = TicksPerMicrosecond();
+		size_t written = 0;
+		for (std::unique_ptr<ThreadBuffer>& buffer : Buffers)
+		{
+			size_t count = buffer->count.load(std::memory_order_acquire);
+			fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", buffer->id, buffer->name.c_str());
+			for (size_t i = 0; i < count; i++)
+			{
+				const Event& event = buffer->events[i];
+				double start = event.begin > StartTicks ? (event.begin - StartTicks) / ticksPerMicrosecond : 0.0;
+				if (event.type == EventType::Counter)
+				{
+					fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%g}}",
+						event.name, buffer->id, start, event.value);
+				}
+				else
+				{
+					double duration = event.end > event.begin ? (event.end - event.begin) / ticksPerMicrosecond : 0.0;
+					fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+						event.name, buffer->id, start, duration);
+				}
+			}
+			written += count;
+		}
+		return written;
+	}
+
+	/// <summary>
+	/// Writes a Chrome trace of the recorded events, for tools without a GPU profile to merge
+	/// </summary>
+	/// <returns>False if the file couldn't be written</returns>
+	static bool WriteTrace(const std::string& path)
+	{
+		FILE* file = fopen(path.c_str(), "w");
+		if (!file)
+		{
+			std::cout << "ERROR::CPU_PROFILER::TRACE_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LearnOpenGL\"}}");
+		size_t count = WriteEvents(file);
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		std::cout << "LOG::CPU_PROFILER::TRACE " << path << " " << count << " events" << std::endl;
+		return true;
+	}
+
+	/// <summary>
+	/// Prints the calls and total time of every scope name, and the dropped events
+	/// </summary>
+	static void Print()
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		double ticksPerMicrosecond = TicksPerMicrosecond();
+		struct Total
+		{
+			const char* name;
+			size_t calls;
+			double milliseconds;
+		};
+		std::vector<Total> totals;
+		std::unordered_map<std::string, size_t> indices;
+		uint64_t dropped = 0;
+		for (std::unique_ptr<ThreadBuffer>& buffer : Buffers)
+		{
+			size_t count = buffer->count.load(std::memory_order_acquire);
+			for (size_t i = 0; i < count; i++)
+			{
+				const Event& event = buffer->events[i];
+				if (event.type != EventType::Scope)
+				{
+					continue;
+				}
+				std::unordered_map<std::string, size_t>::iterator found = indices.emplace(event.name, totals.size()).first;
+				if (found->second == totals.size())
+				{
+					totals.push_back(Total{ event.name, 0, 0.0 });
+				}
+				totals[found->second].calls++;
+				totals[found->second].milliseconds += (event.end - event.begin) / ticksPerMicrosecond / 1000.0;
+			}
+			dropped += buffer->dropped;
+		}
+		for (const Total& total : totals)
+		{
+			std::cout << "LOG::CPU_PROFILER::SCOPE " << total.name << " " << total.calls << " calls, " << total.milliseconds << " ms" << std::endl;
+		}
+		if (dropped)
+		{
+			std::cout << "LOG::CPU_PROFILER::DROPPED " << dropped << " events, raise the capacity of Start()" << std::endl;
+		}
+	}
+
+private:
+	enum class EventType : uint8_t
+	{
+		Scope,
+		Counter
+	};
+
+	struct Event
+	{
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+		double value;
+		EventType type;
+	};
+
+	// events of one thread, written by that thread only
+	struct ThreadBuffer
+	{
+		std::vector<Event> events;
+		std::atomic<size_t> count{ 0 };
+		uint64_t dropped = 0;
+		uint64_t lastFrame = 0;
+		std::string name;
+		int id = 0;
+
+		void push(const Event& event)
+		{
+			size_t index = count.load(std::memory_order_relaxed);
+			if (index >= events.size())
+			{
+				dropped++;
+				return;
+			}
+			events[index] = event;
+			count.store(index + 1, std::memory_order_release);
+		}
+	};
+
+	// the buffers live as long as the process, threads that exit keep their events
+	inline static std::mutex Mutex;
+	inline static std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+	inline static std::atomic<bool> Recording{ false };
+	inline static size_t Capacity = 1 << 16;
+	inline static uint64_t StartTicks = 0;
+	inline static uint64_t StopTicks = 0;
+	inline static std::chrono::steady_clock::time_point StartTime;
+	inline static std::chrono::steady_clock::time_point StopTime;
+
+	static ThreadBuffer*& LocalBuffer()
+	{
+		thread_local ThreadBuffer* buffer = NULL;
+		return buffer;
+	}
+
+	static const char*& ThreadName()
+	{
+		thread_local const char* name = NULL;
+		return name;
+	}
+
+	// buffer of the calling thread, registered on its first event
+	static ThreadBuffer& Local()
+	{
+		ThreadBuffer*& buffer = LocalBuffer();
+		if (!buffer)
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Buffers.emplace_back(new ThreadBuffer());
+			buffer = Buffers.back().get();
+			buffer->events.assign(Capacity, Event());
+			buffer->id = (int)Buffers.size();
+			buffer->name = ThreadName() ? ThreadName() : "thread " + std::to_string(buffer->id);
+		}
+		return *buffer;
+	}
+
+	// clock rate measured over the recording, 1000 ticks per microsecond with steady_clock
+	static double TicksPerMicrosecond()
+	{
+#ifdef CPU_PROFILER_RDTSC
+		uint64_t ticks = Recording.load() ? Now() : StopTicks;
+		std::chrono::steady_clock::time_point time = Recording.load() ? std::chrono::steady_clock::now() : StopTime;
+		double microseconds = std::chrono::duration<double, std::micro>(time - StartTime).count();
+		return microseconds > 0.0 && ticks > StartTicks ? (ticks - StartTicks) / microseconds : 1000.0;
+#else
+		return 1000.0;
+#endif
+	}
+};
+
+/// <summary>
+/// Times its lifetime on the calling thread, see PROFILE_SCOPE
+/// </summary>
+class CpuScope
+{
+public:
+	CpuScope(const char* name)
+		: name(name), begin(CpuProfiler::IsRecording() ? CpuProfiler::Now() : 0)
+	{
+	}
+
+	~CpuScope()
+	{
+		if (begin)
+		{
+			CpuProfiler::Scope(name, begin, CpuProfiler::Now());
+		}
+	}
+
+	CpuScope(const CpuScope&) = delete;
+	CpuScope& operator=(const CpuScope&) = delete;
+
+private:
+	const char* name;
+	uint64_t begin;
+};
+
+#ifdef LEARNOPENGL_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// times the rest of the enclosing block
+#define PROFILE_SCOPE(name) CpuScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) CpuProfiler::Counter(name, (double)(value))
+#define PROFILE_FRAME() CpuProfiler::Frame()
+#define PROFILE_THREAD(name) CpuProfiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+#endif // !CPU_PROFILER_H
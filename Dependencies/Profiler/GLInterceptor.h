@@ -0,0 +1,685 @@
+#ifndef GL_INTERCEPTOR_H
+#define GL_INTERCEPTOR_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+#include <GLExt.h>
+#include <CpuProfiler.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// every entry point of the glad profile (OpenGL 3.3 core), X(name) is called with each of them
+#define GL_INTERCEPTOR_GLAD_ENTRY_POINTS(X) \
+	X(glCullFace) X(glFrontFace) X(glHint) X(glLineWidth) X(glPointSize) X(glPolygonMode) X(glScissor) X(glTexParameterf) \
+	X(glTexParameterfv) X(glTexParameteri) X(glTexParameteriv) X(glTexImage1D) X(glTexImage2D) X(glDrawBuffer) X(glClear) \
+	X(glClearColor) X(glClearStencil) X(glClearDepth) X(glStencilMask) X(glColorMask) X(glDepthMask) X(glDisable) X(glEnable) \
+	X(glFinish) X(glFlush) X(glBlendFunc) X(glLogicOp) X(glStencilFunc) X(glStencilOp) X(glDepthFunc) X(glPixelStoref) \
+	X(glPixelStorei) X(glReadBuffer) X(glReadPixels) X(glGetBooleanv) X(glGetDoublev) X(glGetError) X(glGetFloatv) X(glGetIntegerv) \
+	X(glGetString) X(glGetTexImage) X(glGetTexParameterfv) X(glGetTexParameteriv) X(glGetTexLevelParameterfv) \
+	X(glGetTexLevelParameteriv) X(glIsEnabled) X(glDepthRange) X(glViewport) X(glDrawArrays) X(glDrawElements) X(glPolygonOffset) \
+	X(glCopyTexImage1D) X(glCopyTexImage2D) X(glCopyTexSubImage1D) X(glCopyTexSubImage2D) X(glTexSubImage1D) X(glTexSubImage2D) \
+	X(glBindTexture) X(glDeleteTextures) X(glGenTextures) X(glIsTexture) X(glDrawRangeElements) X(glTexImage3D) X(glTexSubImage3D) \
+	X(glCopyTexSubImage3D) X(glActiveTexture) X(glSampleCoverage) X(glCompressedTexImage3D) X(glCompressedTexImage2D) \
+	X(glCompressedTexImage1D) X(glCompressedTexSubImage3D) X(glCompressedTexSubImage2D) X(glCompressedTexSubImage1D) \
+	X(glGetCompressedTexImage) X(glBlendFuncSeparate) X(glMultiDrawArrays) X(glMultiDrawElements) X(glPointParameterf) \
+	X(glPointParameterfv) X(glPointParameteri) X(glPointParameteriv) X(glBlendColor) X(glBlendEquation) X(glGenQueries) \
+	X(glDeleteQueries) X(glIsQuery) X(glBeginQuery) X(glEndQuery) X(glGetQueryiv) X(glGetQueryObjectiv) X(glGetQueryObjectuiv) \
+	X(glBindBuffer) X(glDeleteBuffers) X(glGenBuffers) X(glIsBuffer) X(glBufferData) X(glBufferSubData) X(glGetBufferSubData) \
+	X(glMapBuffer) X(glUnmapBuffer) X(glGetBufferParameteriv) X(glGetBufferPointerv) X(glBlendEquationSeparate) X(glDrawBuffers) \
+	X(glStencilOpSeparate) X(glStencilFuncSeparate) X(glStencilMaskSeparate) X(glAttachShader) X(glBindAttribLocation) \
+	X(glCompileShader) X(glCreateProgram) X(glCreateShader) X(glDeleteProgram) X(glDeleteShader) X(glDetachShader) \
+	X(glDisableVertexAttribArray) X(glEnableVertexAttribArray) X(glGetActiveAttrib) X(glGetActiveUniform) X(glGetAttachedShaders) \
+	X(glGetAttribLocation) X(glGetProgramiv) X(glGetProgramInfoLog) X(glGetShaderiv) X(glGetShaderInfoLog) X(glGetShaderSource) \
+	X(glGetUniformLocation) X(glGetUniformfv) X(glGetUniformiv) X(glGetVertexAttribdv) X(glGetVertexAttribfv) X(glGetVertexAttribiv) \
+	X(glGetVertexAttribPointerv) X(glIsProgram) X(glIsShader) X(glLinkProgram) X(glShaderSource) X(glUseProgram) X(glUniform1f) \
+	X(glUniform2f) X(glUniform3f) X(glUniform4f) X(glUniform1i) X(glUniform2i) X(glUniform3i) X(glUniform4i) X(glUniform1fv) \
+	X(glUniform2fv) X(glUniform3fv) X(glUniform4fv) X(glUniform1iv) X(glUniform2iv) X(glUniform3iv) X(glUniform4iv) \
+	X(glUniformMatrix2fv) X(glUniformMatrix3fv) X(glUniformMatrix4fv) X(glValidateProgram) X(glVertexAttrib1d) X(glVertexAttrib1dv) \
+	X(glVertexAttrib1f) X(glVertexAttrib1fv) X(glVertexAttrib1s) X(glVertexAttrib1sv) X(glVertexAttrib2d) X(glVertexAttrib2dv) \
+	X(glVertexAttrib2f) X(glVertexAttrib2fv) X(glVertexAttrib2s) X(glVertexAttrib2sv) X(glVertexAttrib3d) X(glVertexAttrib3dv) \
+	X(glVertexAttrib3f) X(glVertexAttrib3fv) X(glVertexAttrib3s) X(glVertexAttrib3sv) X(glVertexAttrib4Nbv) X(glVertexAttrib4Niv) \
+	X(glVertexAttrib4Nsv) X(glVertexAttrib4Nub) X(glVertexAttrib4Nubv) X(glVertexAttrib4Nuiv) X(glVertexAttrib4Nusv) \
+	X(glVertexAttrib4bv) X(glVertexAttrib4d) X(glVertexAttrib4dv) X(glVertexAttrib4f) X(glVertexAttrib4fv) X(glVertexAttrib4iv) \
+	X(glVertexAttrib4s) X(glVertexAttrib4sv) X(glVertexAttrib4ubv) X(glVertexAttrib4uiv) X(glVertexAttrib4usv) \
+	X(glVertexAttribPointer) X(glUniformMatrix2x3fv) X(glUniformMatrix3x2fv) X(glUniformMatrix2x4fv) X(glUniformMatrix4x2fv) \
+	X(glUniformMatrix3x4fv) X(glUniformMatrix4x3fv) X(glColorMaski) X(glGetBooleani_v) X(glGetIntegeri_v) X(glEnablei) X(glDisablei) \
+	X(glIsEnabledi) X(glBeginTransformFeedback) X(glEndTransformFeedback) X(glBindBufferRange) X(glBindBufferBase) \
+	X(glTransformFeedbackVaryings) X(glGetTransformFeedbackVarying) X(glClampColor) X(glBeginConditionalRender) \
+	X(glEndConditionalRender) X(glVertexAttribIPointer) X(glGetVertexAttribIiv) X(glGetVertexAttribIuiv) X(glVertexAttribI1i) \
+	X(glVertexAttribI2i) X(glVertexAttribI3i) X(glVertexAttribI4i) X(glVertexAttribI1ui) X(glVertexAttribI2ui) X(glVertexAttribI3ui) \
+	X(glVertexAttribI4ui) X(glVertexAttribI1iv) X(glVertexAttribI2iv) X(glVertexAttribI3iv) X(glVertexAttribI4iv) \
+	X(glVertexAttribI1uiv) X(glVertexAttribI2uiv) X(glVertexAttribI3uiv) X(glVertexAttribI4uiv) X(glVertexAttribI4bv) \
+	X(glVertexAttribI4sv) X(glVertexAttribI4ubv) X(glVertexAttribI4usv) X(glGetUniformuiv) X(glBindFragDataLocation) \
+	X(glGetFragDataLocation) X(glUniform1ui) X(glUniform2ui) X(glUniform3ui) X(glUniform4ui) X(glUniform1uiv) X(glUniform2uiv) \
+	X(glUniform3uiv) X(glUniform4uiv) X(glTexParameterIiv) X(glTexParameterIuiv) X(glGetTexParameterIiv) X(glGetTexParameterIuiv) \
+	X(glClearBufferiv) X(glClearBufferuiv) X(glClearBufferfv) X(glClearBufferfi) X(glGetStringi) X(glIsRenderbuffer) \
+	X(glBindRenderbuffer) X(glDeleteRenderbuffers) X(glGenRenderbuffers) X(glRenderbufferStorage) X(glGetRenderbufferParameteriv) \
+	X(glIsFramebuffer) X(glBindFramebuffer) X(glDeleteFramebuffers) X(glGenFramebuffers) X(glCheckFramebufferStatus) \
+	X(glFramebufferTexture1D) X(glFramebufferTexture2D) X(glFramebufferTexture3D) X(glFramebufferRenderbuffer) \
+	X(glGetFramebufferAttachmentParameteriv) X(glGenerateMipmap) X(glBlitFramebuffer) X(glRenderbufferStorageMultisample) \
+	X(glFramebufferTextureLayer) X(glMapBufferRange) X(glFlushMappedBufferRange) X(glBindVertexArray) X(glDeleteVertexArrays) \
+	X(glGenVertexArrays) X(glIsVertexArray) X(glDrawArraysInstanced) X(glDrawElementsInstanced) X(glTexBuffer) \
+	X(glPrimitiveRestartIndex) X(glCopyBufferSubData) X(glGetUniformIndices) X(glGetActiveUniformsiv) X(glGetActiveUniformName) \
+	X(glGetUniformBlockIndex) X(glGetActiveUniformBlockiv) X(glGetActiveUniformBlockName) X(glUniformBlockBinding) \
+	X(glDrawElementsBaseVertex) X(glDrawRangeElementsBaseVertex) X(glDrawElementsInstancedBaseVertex) \
+	X(glMultiDrawElementsBaseVertex) X(glProvokingVertex) X(glFenceSync) X(glIsSync) X(glDeleteSync) X(glClientWaitSync) \
+	X(glWaitSync) X(glGetInteger64v) X(glGetSynciv) X(glGetInteger64i_v) X(glGetBufferParameteri64v) X(glFramebufferTexture) \
+	X(glTexImage2DMultisample) X(glTexImage3DMultisample) X(glGetMultisamplefv) X(glSampleMaski) X(glBindFragDataLocationIndexed) \
+	X(glGetFragDataIndex) X(glGenSamplers) X(glDeleteSamplers) X(glIsSampler) X(glBindSampler) X(glSamplerParameteri) \
+	X(glSamplerParameteriv) X(glSamplerParameterf) X(glSamplerParameterfv) X(glSamplerParameterIiv) X(glSamplerParameterIuiv) \
+	X(glGetSamplerParameteriv) X(glGetSamplerParameterIiv) X(glGetSamplerParameterfv) X(glGetSamplerParameterIuiv) X(glQueryCounter) \
+	X(glGetQueryObjecti64v) X(glGetQueryObjectui64v) X(glVertexAttribDivisor) X(glVertexAttribP1ui) X(glVertexAttribP1uiv) \
+	X(glVertexAttribP2ui) X(glVertexAttribP2uiv) X(glVertexAttribP3ui) X(glVertexAttribP3uiv) X(glVertexAttribP4ui) \
+	X(glVertexAttribP4uiv) X(glVertexP2ui) X(glVertexP2uiv) X(glVertexP3ui) X(glVertexP3uiv) X(glVertexP4ui) X(glVertexP4uiv) \
+	X(glTexCoordP1ui) X(glTexCoordP1uiv) X(glTexCoordP2ui) X(glTexCoordP2uiv) X(glTexCoordP3ui) X(glTexCoordP3uiv) X(glTexCoordP4ui) \
+	X(glTexCoordP4uiv) X(glMultiTexCoordP1ui) X(glMultiTexCoordP1uiv) X(glMultiTexCoordP2ui) X(glMultiTexCoordP2uiv) \
+	X(glMultiTexCoordP3ui) X(glMultiTexCoordP3uiv) X(glMultiTexCoordP4ui) X(glMultiTexCoordP4uiv) X(glNormalP3ui) X(glNormalP3uiv) \
+	X(glColorP3ui) X(glColorP3uiv) X(glColorP4ui) X(glColorP4uiv) X(glSecondaryColorP3ui) X(glSecondaryColorP3uiv)
+
+/// <summary>
+/// Debug layer between the samples and the driver: every glad and GLExt entry point is replaced
+/// by a wrapper that counts the calls and times them, and the state setters (program, vertex array,
+/// buffer, texture and framebuffer bindings, capabilities, clear color, viewport...) are compared
+/// with a shadow of the state to count the redundant ones. Frame() closes a frame of the report.
+/// Only the GL thread calls GL, so the counters aren't atomic.
+/// </summary>
+class GLInterceptor
+{
+public:
+	/// <summary>
+	/// Calls, redundant calls and time of an entry point
+	/// </summary>
+	struct EntryPoint
+	{
+		const char* name = NULL;
+		uint64_t calls = 0;
+		uint64_t redundant = 0;
+		uint64_t nanoseconds = 0;
+		// since the last Frame()
+		uint64_t frameCalls = 0;
+		uint64_t frameRedundant = 0;
+		uint64_t frameNanoseconds = 0;
+	};
+
+	/// <summary>
+	/// Totals of a frame and the entry points it called
+	/// </summary>
+	struct FrameReport
+	{
+		uint64_t calls = 0;
+		uint64_t redundant = 0;
+		uint64_t nanoseconds = 0;
+		// index in the entry points, calls and redundant calls
+		std::vector<std::array<uint64_t, 3>> entryPoints;
+	};
+
+	/// <summary>
+	/// Wraps the loaded entry points, call it once after gladLoadGLLoader and GLExt::Load
+	/// (and after any other wrapper, which then becomes the "driver" of the interceptor)
+	/// </summary>
+	static void Install()
+	{
+		if (Installed)
+		{
+			return;
+		}
+		Installed = true;
+#define GL_INTERCEPTOR_INSTALL(name) Hook<&glad_##name>::Install(#name);
+		GL_INTERCEPTOR_GLAD_ENTRY_POINTS(GL_INTERCEPTOR_INSTALL)
+#undef GL_INTERCEPTOR_INSTALL
+		Hook<&GLExt::GetProgramBinary>::Install("glGetProgramBinary");
+		Hook<&GLExt::ProgramBinary>::Install("glProgramBinary");
+		Hook<&GLExt::ProgramParameteri>::Install("glProgramParameteri");
+		Hook<&GLExt::MaxShaderCompilerThreads>::Install("glMaxShaderCompilerThreadsKHR");
+		Hook<&GLExt::BufferStorage>::Install("glBufferStorage");
+		Hook<&GLExt::TexStorage2D>::Install("glTexStorage2D");
+		Hook<&GLExt::TexStorage3D>::Install("glTexStorage3D");
+		Hook<&GLExt::CopyImageSubData>::Install("glCopyImageSubData");
+		Hook<&GLExt::GetTextureHandle>::Install("glGetTextureHandleARB");
+		Hook<&GLExt::MakeTextureHandleResident>::Install("glMakeTextureHandleResidentARB");
+		Hook<&GLExt::MakeTextureHandleNonResident>::Install("glMakeTextureHandleNonResidentARB");
+
+		// the state setters compare with the shadow state before the counting wrapper
+		Check<&glad_glUseProgram>(CheckUseProgram);
+		Check<&glad_glBindVertexArray>(CheckBindVertexArray);
+		Check<&glad_glBindBuffer>(CheckBindBuffer);
+		Check<&glad_glBindBufferBase>(CheckBindBufferBase);
+		Check<&glad_glBindBufferRange>(CheckBindBufferRange);
+		Check<&glad_glActiveTexture>(CheckActiveTexture);
+		Check<&glad_glBindTexture>(CheckBindTexture);
+		Check<&glad_glBindSampler>(CheckBindSampler);
+		Check<&glad_glBindFramebuffer>(CheckBindFramebuffer);
+		Check<&glad_glBindRenderbuffer>(CheckBindRenderbuffer);
+		Check<&glad_glEnable>(CheckEnable);
+		Check<&glad_glDisable>(CheckDisable);
+		Check<&glad_glClearColor>(CheckClearColor);
+		Check<&glad_glViewport>(CheckViewport);
+		Check<&glad_glScissor>(CheckScissor);
+		Check<&glad_glBlendFunc>(CheckBlendFunc);
+		Check<&glad_glBlendFuncSeparate>(CheckBlendFuncSeparate);
+		Check<&glad_glDepthFunc>(CheckDepthFunc);
+		Check<&glad_glDepthMask>(CheckDepthMask);
+		Check<&glad_glCullFace>(CheckCullFace);
+		Check<&glad_glFrontFace>(CheckFrontFace);
+		Check<&glad_glPolygonMode>(CheckPolygonMode);
+		Check<&glad_glPixelStorei>(CheckPixelStorei);
+		// deleting a bound object unbinds it
+		Check<&glad_glDeleteBuffers>(CheckDeleteBuffers);
+		Check<&glad_glDeleteTextures>(CheckDeleteTextures);
+		Check<&glad_glDeleteVertexArrays>(CheckDeleteVertexArrays);
+		Check<&glad_glDeleteFramebuffers>(CheckDeleteFramebuffers);
+		Check<&glad_glDeleteRenderbuffers>(CheckDeleteRenderbuffers);
+		Check<&glad_glDeleteSamplers>(CheckDeleteSamplers);
+		std::cout << "LOG::GL_INTERCEPTOR::INSTALLED " << Entries.size() << " entry points" << std::endl;
+	}
+
+	static bool IsInstalled()
+	{
+		return Installed;
+	}
+
+	/// <summary>
+	/// Closes the current frame of the report: the calls since the previous one
+	/// </summary>
+	static void Frame()
+	{
+		if (!Installed)
+		{
+			return;
+		}
+		FrameCount++;
+		FrameReport frame;
+		for (size_t i = 0; i < Entries.size(); i++)
+		{
+			EntryPoint& entry = Entries[i];
+			if (!entry.frameCalls)
+			{
+				continue;
+			}
+			frame.calls += entry.frameCalls;
+			frame.redundant += entry.frameRedundant;
+			frame.nanoseconds += entry.frameNanoseconds;
+			if (Frames.size() < MAX_FRAMES)
+			{
+				frame.entryPoints.push_back({ i, entry.frameCalls, entry.frameRedundant });
+			}
+			entry.frameCalls = 0;
+			entry.frameRedundant = 0;
+			entry.frameNanoseconds = 0;
+		}
+		PROFILE_COUNTER("gl calls", frame.calls);
+		PROFILE_COUNTER("redundant gl calls", frame.redundant);
+		if (Frames.size() < MAX_FRAMES)
+		{
+			Frames.push_back(std::move(frame));
+		}
+	}
+
+	/// <summary>
+	/// Returns every wrapped entry point, called or not
+	/// </summary>
+	static const std::vector<EntryPoint>& GetEntryPoints()
+	{
+		return Entries;
+	}
+
+	/// <summary>
+	/// Returns the reports of the first frames (MAX_FRAMES at most)
+	/// </summary>
+	static const std::vector<FrameReport>& GetFrames()
+	{
+		return Frames;
+	}
+
+	/// <summary>
+	/// Prints the calls per frame and the entry points that took the most time
+	/// </summary>
+	/// <param name="count">Entry points printed</param>
+	static void Print(size_t count = 10)
+	{
+		double frames = (double)std::max(FrameCount, (uint64_t)1);
+		uint64_t calls = 0, redundant = 0, nanoseconds = 0;
+		for (const EntryPoint& entry : Entries)
+		{
+			calls += entry.calls;
+			redundant += entry.redundant;
+			nanoseconds += entry.nanoseconds;
+		}
+		std::cout << "LOG::GL_INTERCEPTOR::FRAMES " << FrameCount << " frames, " << calls / frames << " calls per frame ("
+			<< redundant / frames << " redundant), " << nanoseconds / frames / 1000.0 << " us per frame in GL calls" << std::endl;
+		for (const EntryPoint* entry : Sorted())
+		{
+			if (!count--)
+			{
+				break;
+			}
+			std::cout << "LOG::GL_INTERCEPTOR::CALL " << entry->name << " " << entry->calls / frames << " per frame, "
+				<< entry->redundant / frames << " redundant, " << entry->nanoseconds / 1e6 << " ms, "
+				<< (double)entry->nanoseconds / entry->calls << " ns per call" << std::endl;
+		}
+	}
+
+	/// <summary>
+	/// Writes the totals of every called entry point and the calls of every frame as JSON
+	/// </summary>
+	/// <param name="path">JSON file, "-" prints it instead</param>
+	/// <param name="scene">Name of the sample</param>
+	/// <returns>False if the file couldn't be written</returns>
+	static bool WriteReport(const std::string& path, const std::string& scene)
+	{
+		FILE* file = path == "-" ? stdout : fopen(path.c_str(), "w");
+		if (!file)
+		{
+			std::cout << "ERROR::GL_INTERCEPTOR::REPORT_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		fprintf(file, "{\n");
+		fprintf(file, "  \"scene\": \"%s\",\n", scene.c_str());
+		fprintf(file, "  \"frames\": %llu,\n", (unsigned long long)FrameCount);
+		fprintf(file, "  \"entry_points\": [");
+		std::vector<const EntryPoint*> sorted = Sorted();
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			const EntryPoint& entry = *sorted[i];
+			fprintf(file, "%s\n    { \"name\": \"%s\", \"calls\": %llu, \"redundant\": %llu, \"total_ms\": %.4f, \"ns_per_call\": %.1f }",
+				i ? "," : "", entry.name, (unsigned long long)entry.calls, (unsigned long long)entry.redundant,
+				entry.nanoseconds / 1e6, (double)entry.nanoseconds / entry.calls);
+		}
+		fprintf(file, "\n  ],\n");
+		// per frame: totals and [calls, redundant] of every entry point called
+		fprintf(file, "  \"per_frame\": [");
+		for (size_t i = 0; i < Frames.size(); i++)
+		{
+			const FrameReport& frame = Frames[i];
+			fprintf(file, "%s\n    { \"calls\": %llu, \"redundant\": %llu, \"cpu_us\": %.2f, \"entry_points\": {",
+				i ? "," : "", (unsigned long long)frame.calls, (unsigned long long)frame.redundant, frame.nanoseconds / 1000.0);
+			for (size_t j = 0; j < frame.entryPoints.size(); j++)
+			{
+				fprintf(file, "%s\"%s\": [%llu, %llu]", j ? ", " : " ", Entries[frame.entryPoints[j][0]].name,
+					(unsigned long long)frame.entryPoints[j][1], (unsigned long long)frame.entryPoints[j][2]);
+			}
+			fprintf(file, " } }");
+		}
+		fprintf(file, "\n  ]\n}\n");
+		if (file != stdout)
+		{
+			fclose(file);
+		}
+		return true;
+	}
+
+	// frames kept for the report, the later ones are only in the totals
+	static constexpr size_t MAX_FRAMES = 10000;
+
+private:
+	// a state value, unknown until set through the interceptor (zero initialized with the shadow state)
+	template <typename T>
+	struct Tracked
+	{
+		T value;
+		bool known;
+
+		// returns true if the value was already set
+		bool set(const T& next)
+		{
+			bool same = known && value == next;
+			value = next;
+			known = true;
+			return same;
+		}
+
+		void unbind(GLuint name)
+		{
+			if (known && value == name)
+			{
+				value = 0;
+			}
+		}
+	};
+
+	struct State
+	{
+		Tracked<GLuint> program;
+		Tracked<GLuint> vertexArray;
+		std::unordered_map<GLenum, Tracked<GLuint>> buffers;
+		Tracked<GLenum> activeTexture;
+		// (unit << 32) | target
+		std::unordered_map<uint64_t, Tracked<GLuint>> textures;
+		std::unordered_map<GLuint, Tracked<GLuint>> samplers;
+		Tracked<GLuint> drawFramebuffer;
+		Tracked<GLuint> readFramebuffer;
+		Tracked<GLuint> renderbuffer;
+		std::unordered_map<GLenum, Tracked<bool>> capabilities;
+		Tracked<std::array<GLfloat, 4>> clearColor;
+		Tracked<std::array<GLint, 4>> viewport;
+		Tracked<std::array<GLint, 4>> scissor;
+		Tracked<std::array<GLenum, 4>> blendFunc;
+		Tracked<GLenum> depthFunc;
+		Tracked<GLboolean> depthMask;
+		Tracked<GLenum> cullFace;
+		Tracked<GLenum> frontFace;
+		Tracked<std::array<GLenum, 2>> polygonMode;
+		std::unordered_map<GLenum, Tracked<GLint>> pixelStore;
+	};
+
+	inline static bool Installed = false;
+	inline static std::vector<EntryPoint> Entries;
+	inline static std::vector<FrameReport> Frames;
+	inline static uint64_t FrameCount = 0;
+	inline static State Shadow{};
+
+	// times a call and counts it
+	class CallTimer
+	{
+	public:
+		CallTimer(size_t index)
+			: entry(Entries[index]), start(std::chrono::steady_clock::now())
+		{
+		}
+
+		~CallTimer()
+		{
+			uint64_t nanoseconds = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			entry.calls++;
+			entry.frameCalls++;
+			entry.nanoseconds += nanoseconds;
+			entry.frameNanoseconds += nanoseconds;
+		}
+
+	private:
+		EntryPoint& entry;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	// wrapper of the entry point stored in *Pointer, one instantiation per entry point
+	template <auto* Pointer, typename Proc = std::remove_pointer_t<decltype(Pointer)>>
+	struct Hook;
+
+	template <auto* Pointer, typename R, typename... Args>
+	struct Hook<Pointer, R(APIENTRY*)(Args...)>
+	{
+		inline static R(APIENTRY* Driver)(Args...) = NULL;
+		inline static size_t Index = 0;
+
+		static R APIENTRY Call(Args... args)
+		{
+			CallTimer timer(Index);
+			return Driver(args...);
+		}
+
+		static void Install(const char* name)
+		{
+			// entry points the context doesn't have stay NULL
+			if (!*Pointer || Driver)
+			{
+				return;
+			}
+			Driver = *Pointer;
+			Index = Entries.size();
+			Entries.emplace_back();
+			Entries.back().name = name;
+			*Pointer = Call;
+		}
+	};
+
+	template <auto* Pointer, typename Proc>
+	static void Check(Proc check)
+	{
+		if (Hook<Pointer>::Driver)
+		{
+			*Pointer = check;
+		}
+	}
+
+	// calls the counting wrapper, counting the call as redundant if told so
+	template <auto* Pointer, typename... Args>
+	static void Forward(bool redundant, Args... args)
+	{
+		if (redundant)
+		{
+			Entries[Hook<Pointer>::Index].redundant++;
+			Entries[Hook<Pointer>::Index].frameRedundant++;
+		}
+		Hook<Pointer>::Call(args...);
+	}
+
+	static void APIENTRY CheckUseProgram(GLuint program)
+	{
+		Forward<&glad_glUseProgram>(Shadow.program.set(program), program);
+	}
+
+	static void APIENTRY CheckBindVertexArray(GLuint array)
+	{
+		bool redundant = Shadow.vertexArray.set(array);
+		if (!redundant)
+		{
+			// the element array buffer binding is part of the vertex array
+			Shadow.buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+		}
+		Forward<&glad_glBindVertexArray>(redundant, array);
+	}
+
+	static void APIENTRY CheckBindBuffer(GLenum target, GLuint buffer)
+	{
+		Forward<&glad_glBindBuffer>(Shadow.buffers[target].set(buffer), target, buffer);
+	}
+
+	// binding to an indexed target binds the generic one too
+	static void APIENTRY CheckBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		Shadow.buffers[target].set(buffer);
+		Forward<&glad_glBindBufferBase>(false, target, index, buffer);
+	}
+
+	static void APIENTRY CheckBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		Shadow.buffers[target].set(buffer);
+		Forward<&glad_glBindBufferRange>(false, target, index, buffer, offset, size);
+	}
+
+	static void APIENTRY CheckActiveTexture(GLenum texture)
+	{
+		Forward<&glad_glActiveTexture>(Shadow.activeTexture.set(texture), texture);
+	}
+
+	static void APIENTRY CheckBindTexture(GLenum target, GLuint texture)
+	{
+		// the binding of an unknown unit can't be compared
+		bool redundant = false;
+		if (Shadow.activeTexture.known)
+		{
+			redundant = Shadow.textures[((uint64_t)Shadow.activeTexture.value << 32) | target].set(texture);
+		}
+		Forward<&glad_glBindTexture>(redundant, target, texture);
+	}
+
+	static void APIENTRY CheckBindSampler(GLuint unit, GLuint sampler)
+	{
+		Forward<&glad_glBindSampler>(Shadow.samplers[unit].set(sampler), unit, sampler);
+	}
+
+	static void APIENTRY CheckBindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		bool redundant;
+		if (target == GL_DRAW_FRAMEBUFFER)
+		{
+			redundant = Shadow.drawFramebuffer.set(framebuffer);
+		}
+		else if (target == GL_READ_FRAMEBUFFER)
+		{
+			redundant = Shadow.readFramebuffer.set(framebuffer);
+		}
+		else
+		{
+			// GL_FRAMEBUFFER binds both
+			redundant = Shadow.drawFramebuffer.set(framebuffer);
+			redundant = Shadow.readFramebuffer.set(framebuffer) && redundant;
+		}
+		Forward<&glad_glBindFramebuffer>(redundant, target, framebuffer);
+	}
+
+	static void APIENTRY CheckBindRenderbuffer(GLenum target, GLuint renderbuffer)
+	{
+		Forward<&glad_glBindRenderbuffer>(Shadow.renderbuffer.set(renderbuffer), target, renderbuffer);
+	}
+
+	static void APIENTRY CheckEnable(GLenum capability)
+	{
+		Forward<&glad_glEnable>(Shadow.capabilities[capability].set(true), capability);
+	}
+
+	static void APIENTRY CheckDisable(GLenum capability)
+	{
+		Forward<&glad_glDisable>(Shadow.capabilities[capability].set(false), capability);
+	}
+
+	static void APIENTRY CheckClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	{
+		Forward<&glad_glClearColor>(Shadow.clearColor.set({ red, green, blue, alpha }), red, green, blue, alpha);
+	}
+
+	static void APIENTRY CheckViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		Forward<&glad_glViewport>(Shadow.viewport.set({ x, y, width, height }), x, y, width, height);
+	}
+
+	static void APIENTRY CheckScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		Forward<&glad_glScissor>(Shadow.scissor.set({ x, y, width, height }), x, y, width, height);
+	}
+
+	static void APIENTRY CheckBlendFunc(GLenum source, GLenum destination)
+	{
+		Forward<&glad_glBlendFunc>(Shadow.blendFunc.set({ source, destination, source, destination }), source, destination);
+	}
+
+	static void APIENTRY CheckBlendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha)
+	{
+		Forward<&glad_glBlendFuncSeparate>(Shadow.blendFunc.set({ sourceRGB, destinationRGB, sourceAlpha, destinationAlpha }),
+			sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+	}
+
+	static void APIENTRY CheckDepthFunc(GLenum function)
+	{
+		Forward<&glad_glDepthFunc>(Shadow.depthFunc.set(function), function);
+	}
+
+	static void APIENTRY CheckDepthMask(GLboolean flag)
+	{
+		Forward<&glad_glDepthMask>(Shadow.depthMask.set(flag), flag);
+	}
+
+	static void APIENTRY CheckCullFace(GLenum mode)
+	{
+		Forward<&glad_glCullFace>(Shadow.cullFace.set(mode), mode);
+	}
+
+	static void APIENTRY CheckFrontFace(GLenum mode)
+	{
+		Forward<&glad_glFrontFace>(Shadow.frontFace.set(mode), mode);
+	}
+
+	static void APIENTRY CheckPolygonMode(GLenum face, GLenum mode)
+	{
+		Forward<&glad_glPolygonMode>(Shadow.polygonMode.set({ face, mode }), face, mode);
+	}
+
+	static void APIENTRY CheckPixelStorei(GLenum name, GLint value)
+	{
+		Forward<&glad_glPixelStorei>(Shadow.pixelStore[name].set(value), name, value);
+	}
+
+	static void APIENTRY CheckDeleteBuffers(GLsizei count, const GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			for (std::pair<const GLenum, Tracked<GLuint>>& binding : Shadow.buffers)
+			{
+				binding.second.unbind(buffers[i]);
+			}
+		}
+		Forward<&glad_glDeleteBuffers>(false, count, buffers);
+	}
+
+	static void APIENTRY CheckDeleteTextures(GLsizei count, const GLuint* textures)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			for (std::pair<const uint64_t, Tracked<GLuint>>& binding : Shadow.textures)
+			{
+				binding.second.unbind(textures[i]);
+			}
+		}
+		Forward<&glad_glDeleteTextures>(false, count, textures);
+	}
+
+	static void APIENTRY CheckDeleteVertexArrays(GLsizei count, const GLuint* arrays)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			if (Shadow.vertexArray.known && Shadow.vertexArray.value == arrays[i] && arrays[i])
+			{
+				// back to the default vertex array and its element array buffer
+				Shadow.vertexArray.value = 0;
+				Shadow.buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+			}
+		}
+		Forward<&glad_glDeleteVertexArrays>(false, count, arrays);
+	}
+
+	static void APIENTRY CheckDeleteFramebuffers(GLsizei count, const GLuint* framebuffers)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			Shadow.drawFramebuffer.unbind(framebuffers[i]);
+			Shadow.readFramebuffer.unbind(framebuffers[i]);
+		}
+		Forward<&glad_glDeleteFramebuffers>(false, count, framebuffers);
+	}
+
+	static void APIENTRY CheckDeleteRenderbuffers(GLsizei count, const GLuint* renderbuffers)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			Shadow.renderbuffer.unbind(renderbuffers[i]);
+		}
+		Forward<&glad_glDeleteRenderbuffers>(false, count, renderbuffers);
+	}
+
+	static void APIENTRY CheckDeleteSamplers(GLsizei count, const GLuint* samplers)
+	{
+		for (GLsizei i = 0; i < count; i++)
+		{
+			for (std::pair<const GLuint, Tracked<GLuint>>& binding : Shadow.samplers)
+			{
+				binding.second.unbind(samplers[i]);
+			}
+		}
+		Forward<&glad_glDeleteSamplers>(false, count, samplers);
+	}
+
+	// called entry points, the most expensive first
+	static std::vector<const EntryPoint*> Sorted()
+	{
+		std::vector<const EntryPoint*> sorted;
+		for (const EntryPoint& entry : Entries)
+		{
+			if (entry.calls)
+			{
+				sorted.push_back(&entry);
+			}
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const EntryPoint* a, const EntryPoint* b) { return a->nanoseconds > b->nanoseconds; });
+		return sorted;
+	}
+};
+
+#endif // !GL_INTERCEPTOR_H
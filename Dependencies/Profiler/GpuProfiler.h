@@ -0,0 +1,449 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Times the GPU work of named scopes with GL_TIMESTAMP queries (GL 3.3 / ARB_timer_query).
+/// Every frame has its own set of queries in a ring of latency + 1 frames: the results of a frame
+/// are read latency frames later, when the GPU is long done with them, so nothing stalls.
+/// Scopes nest (a timestamp pair each, unlike GL_TIME_ELAPSED); the whole frame is the root scope.
+/// The durations feed rolling statistics per scope name and a trace viewable in chrome://tracing or Perfetto.
+/// </summary>
+class GpuProfiler
+{
+public:
+	/// <summary>
+	/// Rolling statistics of a scope over the last frames, in milliseconds
+	/// </summary>
+	struct Statistics
+	{
+		std::string name;
+		// nesting depth where the scope was first seen, 0 is the frame
+		int depth = 0;
+		double last = 0.0;
+		double average = 0.0;
+		double min = 0.0;
+		double max = 0.0;
+		// frames in the window
+		size_t samples = 0;
+	};
+
+	/// <summary>
+	/// Creates the profiler of the current context and makes it the active one, used by GpuScope
+	/// </summary>
+	/// <param name="latency">Frames between issuing the queries and reading them back</param>
+	/// <param name="history">Frames averaged by the statistics</param>
+	/// <param name="traceCapacity">Scopes kept for the trace, the later ones are only in the statistics</param>
+	GpuProfiler(unsigned int latency = 3, size_t history = 120, size_t traceCapacity = 100000)
+		: frames(std::max(latency, 1u) + 1), history(std::max(history, (size_t)1)), traceCapacity(traceCapacity)
+	{
+		supported = glad_glQueryCounter != NULL && glad_glGetQueryObjectui64v != NULL;
+		if (!supported)
+		{
+			std::cout << "LOG::GPU_PROFILER::UNSUPPORTED timer queries not available" << std::endl;
+			return;
+		}
+		// GPU timestamps are mapped to the time since this point
+		GLint64 now = 0;
+		glGetInteger64v(GL_TIMESTAMP, &now);
+		gpuStart = (uint64_t)now;
+		cpuStart = std::chrono::steady_clock::now();
+		Current = this;
+		begin("frame");
+	}
+
+	~GpuProfiler()
+	{
+		if (Current == this)
+		{
+			Current = NULL;
+		}
+		for (Frame& frame : frames)
+		{
+			if (!frame.queries.empty())
+			{
+				glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+			}
+		}
+	}
+
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	/// <summary>
+	/// Returns the active profiler, NULL when not profiling
+	/// </summary>
+	static GpuProfiler* Active()
+	{
+		return Current;
+	}
+
+	bool isSupported() const
+	{
+		return supported;
+	}
+
+	/// <summary>
+	/// Opens a scope: the GPU time of the commands issued until end() is accounted to it
+	/// </summary>
+	/// <param name="name">Name of the scope, a string that outlives the profiler (a literal)</param>
+	void begin(const char* name)
+	{
+		if (!supported)
+		{
+			return;
+		}
+		Frame& frame = frames[frameIndex % frames.size()];
+		Scope scope;
+		scope.name = name;
+		scope.depth = (int)open.size();
+		scope.begin = query(frame);
+		scope.end = 0;
+		glQueryCounter(scope.begin, GL_TIMESTAMP);
+		open.push_back(frame.scopes.size());
+		frame.scopes.push_back(scope);
+	}
+
+	/// <summary>
+	/// Closes the innermost scope
+	/// </summary>
+	void end()
+	{
+		// the frame scope is closed by frame() only
+		if (!supported || open.size() <= 1)
+		{
+			return;
+		}
+		Frame& frame = frames[frameIndex % frames.size()];
+		Scope& scope = frame.scopes[open.back()];
+		open.pop_back();
+		scope.end = query(frame);
+		glQueryCounter(scope.end, GL_TIMESTAMP);
+	}
+
+	/// <summary>
+	/// Ends the frame and starts the next one, once per frame before presenting it;
+	/// collects the frame issued latency frames ago
+	/// </summary>
+	void frame()
+	{
+		if (!supported)
+		{
+			return;
+		}
+		// scopes left open end with the frame
+		while (open.size() > 1)
+		{
+			end();
+		}
+		Frame& current = frames[frameIndex % frames.size()];
+		current.scopes[0].end = query(current);
+		glQueryCounter(current.scopes[0].end, GL_TIMESTAMP);
+		open.clear();
+
+		frameIndex++;
+		Frame& next = frames[frameIndex % frames.size()];
+		collect(next, false);
+		begin("frame");
+	}
+
+	/// <summary>
+	/// Waits for the frames in flight and collects them, before reading the statistics or the trace at exit
+	/// </summary>
+	void flush()
+	{
+		if (!supported)
+		{
+			return;
+		}
+		glFinish();
+		// from the oldest frame to the current one, which is left open
+		for (size_t i = 1; i < frames.size(); i++)
+		{
+			collect(frames[(frameIndex + i) % frames.size()], true);
+		}
+	}
+
+	/// <summary>
+	/// Returns the statistics of every scope, in the order they were first seen
+	/// </summary>
+	std::vector<Statistics> getStatistics() const
+	{
+		std::vector<Statistics> result;
+		for (const Samples& samples : scopes)
+		{
+			Statistics statistics;
+			statistics.name = samples.name;
+			statistics.depth = samples.depth;
+			statistics.samples = samples.values.size();
+			if (!samples.values.empty())
+			{
+				statistics.last = samples.values[(samples.next + samples.values.size() - 1) % samples.values.size()];
+				statistics.min = statistics.max = statistics.last;
+				double sum = 0.0;
+				for (double value : samples.values)
+				{
+					sum += value;
+					statistics.min = std::min(statistics.min, value);
+					statistics.max = std::max(statistics.max, value);
+				}
+				statistics.average = sum / samples.values.size();
+			}
+			result.push_back(statistics);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Returns the number of frames collected, and of the ones dropped because their queries weren't ready
+	/// </summary>
+	uint64_t getFrameCount() const
+	{
+		return collected;
+	}
+
+	uint64_t getDroppedCount() const
+	{
+		return dropped;
+	}
+
+	/// <summary>
+	/// Returns the time GPU timestamps are relative to in the trace
+	/// </summary>
+	std::chrono::steady_clock::time_point getStartTime() const
+	{
+		return cpuStart;
+	}
+
+	/// <summary>
+	/// Prints the statistics, a line per scope indented by depth
+	/// </summary>
+	void print() const
+	{
+		std::cout << "LOG::GPU_PROFILER::FRAMES " << collected << " collected, " << dropped << " dropped" << std::endl;
+		for (const Statistics& statistics : getStatistics())
+		{
+			std::cout << "LOG::GPU_PROFILER::SCOPE " << std::string(statistics.depth * 2, ' ') << statistics.name << " avg " << statistics.average
+				<< " ms, min " << statistics.min << " ms, max " << statistics.max << " ms (" << statistics.samples << " frames)" << std::endl;
+		}
+	}
+
+	/// <summary>
+	/// Writes the collected scopes as a Chrome trace (JSON), on a "GPU" track
+	/// </summary>
+	/// <returns>False if the file couldn't be written</returns>
+	bool writeTrace(const std::string& path) const
+	{
+		FILE* file = fopen(path.c_str(), "w");
+		if (!file)
+		{
+			std::cout << "ERROR::GPU_PROFILER::TRACE_NOT_WRITTEN " << path << std::endl;
+			return false;
+		}
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LearnOpenGL\"}}");
+		writeEvents(file, cpuStart);
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		std::cout << "LOG::GPU_PROFILER::TRACE " << path << " " << trace.size() << " scopes" << std::endl;
+		return true;
+	}
+
+	/// <summary>
+	/// Writes the collected scopes as Chrome trace events, each preceded by a comma,
+	/// so they merge into the trace of the CPU profiler
+	/// </summary>
+	/// <param name="epoch">Time the trace is relative to</param>
+	void writeEvents(FILE* file, std::chrono::steady_clock::time_point epoch) const
+	{
+		double offset = std::chrono::duration<double, std::micro>(cpuStart - epoch).count();
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", TRACE_THREAD);
+		for (const TraceEvent& event : trace)
+		{
+			// microseconds, a scope starting before the profiler (clock skew) is clamped to its start
+			double start = offset + (event.begin > gpuStart ? (event.begin - gpuStart) / 1000.0 : 0.0);
+			double duration = event.end > event.begin ? (event.end - event.begin) / 1000.0 : 0.0;
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+				event.name, TRACE_THREAD, std::max(start, 0.0), duration, (unsigned long long)event.frame);
+		}
+	}
+
+private:
+	// track of the GPU scopes in the trace
+	static const int TRACE_THREAD = 0;
+
+	struct Scope
+	{
+		const char* name;
+		int depth;
+		GLuint begin;
+		GLuint end;
+	};
+
+	// queries and scopes of a frame in the ring
+	struct Frame
+	{
+		std::vector<GLuint> queries;
+		size_t used = 0;
+		std::vector<Scope> scopes;
+		uint64_t index = 0;
+	};
+
+	// rolling window of a scope name
+	struct Samples
+	{
+		std::string name;
+		int depth;
+		std::vector<double> values;
+		size_t next = 0;
+	};
+
+	struct TraceEvent
+	{
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+		uint64_t frame;
+	};
+
+	inline static GpuProfiler* Current = NULL;
+
+	bool supported = false;
+	std::vector<Frame> frames;
+	uint64_t frameIndex = 0;
+	// scopes of the current frame not ended yet, the frame scope first
+	std::vector<size_t> open;
+	size_t history;
+	size_t traceCapacity;
+	std::vector<Samples> scopes;
+	std::unordered_map<std::string, size_t> scopeIndices;
+	std::vector<TraceEvent> trace;
+	uint64_t collected = 0;
+	uint64_t dropped = 0;
+	uint64_t gpuStart = 0;
+	std::chrono::steady_clock::time_point cpuStart;
+
+	// next query object of a frame, created the first time the frame needs that many
+	GLuint query(Frame& frame)
+	{
+		if (frame.used == frame.queries.size())
+		{
+			GLuint id;
+			glGenQueries(1, &id);
+			frame.queries.push_back(id);
+		}
+		if (frame.used == 0)
+		{
+			frame.index = frameIndex;
+		}
+		return frame.queries[frame.used++];
+	}
+
+	// reads back a frame and frees its queries for reuse, wait says whether results may block
+	void collect(Frame& frame, bool wait)
+	{
+		if (frame.scopes.empty() || frame.scopes[0].end == 0)
+		{
+			frame.scopes.clear();
+			frame.used = 0;
+			return;
+		}
+		// timestamps complete in order: when the last one is there, so are the others
+		GLint available = GL_TRUE;
+		if (!wait)
+		{
+			glGetQueryObjectiv(frame.scopes[0].end, GL_QUERY_RESULT_AVAILABLE, &available);
+		}
+		if (available)
+		{
+			for (const Scope& scope : frame.scopes)
+			{
+				GLuint64 begin = 0;
+				GLuint64 end = 0;
+				glGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &end);
+				record(scope, begin, end, frame.index);
+			}
+			collected++;
+		}
+		else
+		{
+			// the queries are reissued anyway, the GPU is more than latency frames behind
+			dropped++;
+		}
+		frame.scopes.clear();
+		frame.used = 0;
+	}
+
+	void record(const Scope& scope, uint64_t begin, uint64_t end, uint64_t frame)
+	{
+		std::unordered_map<std::string, size_t>::iterator found = scopeIndices.find(scope.name);
+		if (found == scopeIndices.end())
+		{
+			found = scopeIndices.emplace(scope.name, scopes.size()).first;
+			Samples samples;
+			samples.name = scope.name;
+			samples.depth = scope.depth;
+			scopes.push_back(samples);
+		}
+		Samples& samples = scopes[found->second];
+		double milliseconds = end > begin ? (end - begin) / 1e6 : 0.0;
+		if (samples.values.size() < history)
+		{
+			samples.values.push_back(milliseconds);
+		}
+		else
+		{
+			samples.values[samples.next] = milliseconds;
+		}
+		samples.next = (samples.next + 1) % history;
+
+		if (trace.size() < traceCapacity)
+		{
+			trace.push_back({ scope.name, begin, end, frame });
+		}
+	}
+};
+
+/// <summary>
+/// Times the GPU work issued during its lifetime in the active GpuProfiler, nothing when not profiling:
+/// { GpuScope scope("opaque"); ... draw calls ... }
+/// </summary>
+class GpuScope
+{
+public:
+	GpuScope(const char* name)
+		: profiler(GpuProfiler::Active())
+	{
+		if (profiler)
+		{
+			profiler->begin(name);
+		}
+	}
+
+	~GpuScope()
+	{
+		if (profiler)
+		{
+			profiler->end();
+		}
+	}
+
+	GpuScope(const GpuScope&) = delete;
+	GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+	GpuProfiler* profiler;
+};
+
+#endif // !GPU_PROFILER_H
@@ -0,0 +1,923 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glad/glad.h> // GL enums and types only, no GL function is called
+
+#include <SoftwareTexture.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RASTERIZER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SOFTWARE_RASTERIZER_NEON
+#include <arm_neon.h>
+#endif
+
+/// <summary>
+/// Shaders of the software rasterizer, C++ callables standing in for the GLSL ones
+/// </summary>
+struct SoftwareProgram
+{
+	// gl_Position from the attributes (indexed by location, missing components are 0, 0, 0, 1),
+	// writes the varyings interpolated for the fragment shader
+	std::function<Vec4(const Vec4* attributes, float* varyings)> vertex;
+	// color of a pixel from the interpolated varyings, components clamped to [0, 1]
+	std::function<Vec4(const SoftwareFragment& fragment)> fragment;
+	// number of varyings written by vertex, up to SoftwareFragment::MAX_VARYINGS
+	int varyings = 0;
+};
+
+/// <summary>
+/// Renders triangles on the CPU with the GL object model the samples use: buffers,
+/// vertex arrays holding the attribute layout and the element buffer, glDrawArrays/glDrawElements
+/// (GL_TRIANGLES, strips and fans) into an RGBA8 framebuffer, rows bottom first.
+/// Every draw runs the vertex shader over the referenced vertices, clips against the near/far
+/// planes and a guard band, snaps to 1/16 pixel and bins the triangles into 64x64 tiles;
+/// the tiles are then rasterized in parallel with half-space edge functions, 4 pixels at a time
+/// (SSE2/NEON), each tile by one worker in submission order, so the result doesn't depend on
+/// the number of threads. No depth test nor blending: the samples use neither.
+/// </summary>
+class SoftwareRasterizer
+{
+public:
+	static constexpr int TILE_SIZE = 64;
+	// the guard band keeps the edge functions of a tile in 32 bits
+	static constexpr int MAX_VIEWPORT = 4096;
+
+	/// <summary>
+	/// Usage counters, summed over the draws
+	/// </summary>
+	struct Statistics
+	{
+		uint64_t draws = 0;
+		uint64_t vertices = 0;
+		// assembled, then left after clipping and degenerate ones
+		uint64_t triangles = 0;
+		uint64_t rasterized = 0;
+		uint64_t fragments = 0;
+	};
+
+	/// <summary>
+	/// Creates the framebuffer, cleared to black, and the workers
+	/// </summary>
+	/// <param name="width">Framebuffer width</param>
+	/// <param name="height">Framebuffer height</param>
+	/// <param name="threads">Workers, 0 uses one per core minus the calling thread, 1 renders on the calling thread</param>
+	SoftwareRasterizer(int width, int height, unsigned int threads = 0)
+		: width(width), height(height), colorBuffer((size_t)width * height, 0xFF000000u)
+	{
+		if (threads != 1)
+		{
+			pool.reset(new ThreadPool(threads));
+		}
+		tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		bins.resize((size_t)tilesX * tilesY);
+		viewport(0, 0, width, height);
+		// name 0 is the default vertex array
+		vertexArrays.emplace_back();
+	}
+
+	SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+	SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+	GLuint genBuffer()
+	{
+		buffers.emplace_back();
+		return (GLuint)buffers.size();
+	}
+
+	/// <summary>
+	/// Binds GL_ARRAY_BUFFER, or GL_ELEMENT_ARRAY_BUFFER to the bound vertex array
+	/// </summary>
+	void bindBuffer(GLenum target, GLuint buffer)
+	{
+		if (target == GL_ELEMENT_ARRAY_BUFFER)
+		{
+			vertexArrays[boundVertexArray].elementBuffer = buffer;
+		}
+		else
+		{
+			arrayBuffer = buffer;
+		}
+	}
+
+	/// <summary>
+	/// Copies data into the buffer bound to target
+	/// </summary>
+	void bufferData(GLenum target, size_t size, const void* data)
+	{
+		GLuint buffer = target == GL_ELEMENT_ARRAY_BUFFER ? vertexArrays[boundVertexArray].elementBuffer : arrayBuffer;
+		if (buffer == 0)
+		{
+			std::cout << "ERROR::SOFTWARE_RASTERIZER::NO_BUFFER_BOUND" << std::endl;
+			return;
+		}
+		std::vector<unsigned char>& storage = buffers[buffer - 1];
+		storage.resize(size);
+		if (data)
+		{
+			memcpy(storage.data(), data, size);
+		}
+	}
+
+	GLuint genVertexArray()
+	{
+		vertexArrays.emplace_back();
+		return (GLuint)vertexArrays.size() - 1;
+	}
+
+	void bindVertexArray(GLuint vertexArray)
+	{
+		boundVertexArray = vertexArray;
+	}
+
+	/// <summary>
+	/// Sets the layout of an attribute of the bound vertex array, read from the bound GL_ARRAY_BUFFER
+	/// </summary>
+	/// <param name="index">Attribute location</param>
+	/// <param name="size">Components, 1 to 4</param>
+	/// <param name="type">GL_FLOAT or GL_UNSIGNED_BYTE</param>
+	/// <param name="normalized">Unsigned bytes are divided by 255</param>
+	/// <param name="stride">Bytes between two vertices, 0 when tightly packed</param>
+	/// <param name="offset">Offset of the first vertex in the buffer</param>
+	void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, size_t offset)
+	{
+		if (index >= MAX_ATTRIBUTES || (type != GL_FLOAT && type != GL_UNSIGNED_BYTE))
+		{
+			std::cout << "ERROR::SOFTWARE_RASTERIZER::UNSUPPORTED_ATTRIBUTE " << index << std::endl;
+			return;
+		}
+		Attribute& attribute = vertexArrays[boundVertexArray].attributes[index];
+		attribute.buffer = arrayBuffer;
+		attribute.size = size;
+		attribute.type = type;
+		attribute.normalized = normalized == GL_TRUE;
+		attribute.stride = stride ? stride : size * (type == GL_FLOAT ? 4 : 1);
+		attribute.offset = offset;
+	}
+
+	void enableVertexAttribArray(GLuint index)
+	{
+		vertexArrays[boundVertexArray].attributes[index].enabled = true;
+	}
+
+	void disableVertexAttribArray(GLuint index)
+	{
+		vertexArrays[boundVertexArray].attributes[index].enabled = false;
+	}
+
+	/// <summary>
+	/// Maps normalized device coordinates to the framebuffer, at most MAX_VIEWPORT wide and high
+	/// </summary>
+	void viewport(int x, int y, int width, int height)
+	{
+		view[0] = x;
+		view[1] = y;
+		view[2] = std::min(std::max(width, 1), MAX_VIEWPORT);
+		view[3] = std::min(std::max(height, 1), MAX_VIEWPORT);
+		// window coordinates stay within MAX_VIEWPORT * 2 of the viewport center,
+		// so the edge functions of a tile fit 32 bits
+		bandX = (float)(MAX_VIEWPORT * 2) / view[2];
+		bandY = (float)(MAX_VIEWPORT * 2) / view[3];
+	}
+
+	void clearColor(float r, float g, float b, float a)
+	{
+		clearValue = Pack(Vec4(r, g, b, a));
+	}
+
+	/// <summary>
+	/// Fills the framebuffer with the clear color
+	/// </summary>
+	void clear()
+	{
+		std::fill(colorBuffer.begin(), colorBuffer.end(), clearValue);
+	}
+
+	void useProgram(const SoftwareProgram* program)
+	{
+		this->program = program;
+	}
+
+	/// <summary>
+	/// Draws count vertices of the bound vertex array from first
+	/// </summary>
+	/// <param name="mode">GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_TRIANGLE_FAN</param>
+	void drawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		std::vector<uint32_t> indices(count);
+		for (GLsizei i = 0; i < count; i++)
+		{
+			indices[i] = (uint32_t)(first + i);
+		}
+		draw(mode, indices);
+	}
+
+	/// <summary>
+	/// Draws count indices of the element buffer of the bound vertex array
+	/// </summary>
+	/// <param name="mode">GL_TRIANGLES, GL_TRIANGLE_STRIP or GL_TRIANGLE_FAN</param>
+	/// <param name="type">GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE</param>
+	/// <param name="offset">Byte offset of the first index in the element buffer</param>
+	void drawElements(GLenum mode, GLsizei count, GLenum type, size_t offset)
+	{
+		GLuint buffer = vertexArrays[boundVertexArray].elementBuffer;
+		size_t indexSize = type == GL_UNSIGNED_INT ? 4 : type == GL_UNSIGNED_SHORT ? 2 : 1;
+		if (buffer == 0 || offset + count * indexSize > buffers[buffer - 1].size())
+		{
+			std::cout << "ERROR::SOFTWARE_RASTERIZER::INVALID_ELEMENT_BUFFER" << std::endl;
+			return;
+		}
+		const unsigned char* data = buffers[buffer - 1].data() + offset;
+		std::vector<uint32_t> indices(count);
+		for (GLsizei i = 0; i < count; i++)
+		{
+			if (type == GL_UNSIGNED_INT)
+			{
+				memcpy(&indices[i], data + i * 4, 4);
+			}
+			else if (type == GL_UNSIGNED_SHORT)
+			{
+				uint16_t index;
+				memcpy(&index, data + i * 2, 2);
+				indices[i] = index;
+			}
+			else
+			{
+				indices[i] = data[i];
+			}
+		}
+		draw(mode, indices);
+	}
+
+	/// <summary>
+	/// Reads back the framebuffer as tightly packed RGB rows, bottom row first, like Context::readPixels
+	/// </summary>
+	void readPixels(std::vector<unsigned char>& pixels) const
+	{
+		pixels.resize((size_t)width * height * 3);
+		for (size_t i = 0; i < colorBuffer.size(); i++)
+		{
+			uint32_t color = colorBuffer[i];
+			pixels[i * 3 + 0] = (unsigned char)color;
+			pixels[i * 3 + 1] = (unsigned char)(color >> 8);
+			pixels[i * 3 + 2] = (unsigned char)(color >> 16);
+		}
+	}
+
+	/// <summary>
+	/// Returns the RGBA8 framebuffer, rows bottom first
+	/// </summary>
+	const uint32_t* getPixels() const
+	{
+		return colorBuffer.data();
+	}
+
+	int getWidth() const
+	{
+		return width;
+	}
+
+	int getHeight() const
+	{
+		return height;
+	}
+
+	/// <summary>
+	/// Returns the number of threads rasterizing tiles
+	/// </summary>
+	size_t getThreadCount() const
+	{
+		return pool ? pool->getCount() : 1;
+	}
+
+	const Statistics& getStatistics() const
+	{
+		return statistics;
+	}
+
+	void resetStatistics()
+	{
+		statistics = Statistics();
+	}
+
+private:
+	static constexpr int MAX_ATTRIBUTES = 16;
+	// 1/16 pixel precision, the GL minimum (GL_SUBPIXEL_BITS)
+	static constexpr int SUBPIXEL_BITS = 4;
+	static constexpr int SUBPIXEL_ONE = 1 << SUBPIXEL_BITS;
+	static constexpr int MAX_CLIP_VERTICES = 9;
+	static constexpr int BLOCK_SIZE = 8;
+
+	struct Attribute
+	{
+		GLuint buffer = 0;
+		int size = 4;
+		GLenum type = GL_FLOAT;
+		bool normalized = false;
+		size_t stride = 16;
+		size_t offset = 0;
+		bool enabled = false;
+	};
+
+	struct VertexArray
+	{
+		Attribute attributes[MAX_ATTRIBUTES];
+		GLuint elementBuffer = 0;
+	};
+
+	// shaded vertex: clip position then the varyings
+	struct ClipVertex
+	{
+		float data[4 + SoftwareFragment::MAX_VARYINGS];
+	};
+
+	// triangle ready for rasterization
+	struct Triangle
+	{
+		// edge functions E = A * x + B * y + C in 1/16 pixel units, C biased by the fill rule
+		int32_t a[3];
+		int32_t b[3];
+		int64_t c[3];
+		// covered pixels are inside this rectangle, inclusive
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		// the planes are relative to this point, in pixels
+		float originX;
+		float originY;
+		// 1/w then the varyings/w, stored by the setup chunk
+		size_t planeOffset;
+		const float (*planes)[3];
+	};
+
+	// triangles set up by a worker, kept between draws so their storage is reused
+	struct SetupChunk
+	{
+		std::vector<Triangle> triangles;
+		std::vector<float> planes;
+	};
+
+	int width;
+	int height;
+	std::vector<uint32_t> colorBuffer;
+	uint32_t clearValue = 0xFF000000u;
+	int view[4];
+	// guard band in normalized device coordinates
+	float bandX;
+	float bandY;
+
+	std::vector<std::vector<unsigned char>> buffers;
+	std::vector<VertexArray> vertexArrays;
+	GLuint boundVertexArray = 0;
+	GLuint arrayBuffer = 0;
+	const SoftwareProgram* program = NULL;
+
+	int tilesX;
+	int tilesY;
+	// triangles touching every tile, in submission order
+	std::vector<std::vector<const Triangle*>> bins;
+	std::vector<SetupChunk> setups;
+	std::unique_ptr<ThreadPool> pool;
+	Statistics statistics;
+
+	static uint32_t Pack(const Vec4& color)
+	{
+		auto unorm = [](float value) { return (uint32_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+		return unorm(color.x) | unorm(color.y) << 8 | unorm(color.z) << 16 | unorm(color.w) << 24;
+	}
+
+	static int FloorDivide(int64_t value, int divisor)
+	{
+		return (int)(value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor));
+	}
+
+	// runs job(begin, end) over [0, count) in chunks on the workers, or inline
+	template <typename Job>
+	void parallelFor(size_t count, size_t minChunk, const Job& job)
+	{
+		size_t chunks = pool ? std::min(pool->getCount() * 4, (count + minChunk - 1) / minChunk) : 1;
+		if (chunks <= 1)
+		{
+			job(0, count, 0);
+			return;
+		}
+		std::vector<std::future<void>> jobs;
+		for (size_t i = 0; i < chunks; i++)
+		{
+			jobs.push_back(pool->submit([&job, i, chunks, count]() { job(count * i / chunks, count * (i + 1) / chunks, i); }));
+		}
+		for (std::future<void>& result : jobs)
+		{
+			result.get();
+		}
+	}
+
+	void draw(GLenum mode, const std::vector<uint32_t>& indices)
+	{
+		if (!program || !program->vertex || !program->fragment || program->varyings > SoftwareFragment::MAX_VARYINGS)
+		{
+			std::cout << "ERROR::SOFTWARE_RASTERIZER::INVALID_PROGRAM" << std::endl;
+			return;
+		}
+		if (mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP && mode != GL_TRIANGLE_FAN)
+		{
+			std::cout << "ERROR::SOFTWARE_RASTERIZER::UNSUPPORTED_MODE " << mode << std::endl;
+			return;
+		}
+		if (indices.size() < 3)
+		{
+			return;
+		}
+		statistics.draws++;
+
+		// vertex shading, once per vertex of the referenced range
+		uint32_t first = *std::min_element(indices.begin(), indices.end());
+		uint32_t last = *std::max_element(indices.begin(), indices.end());
+		const VertexArray& vertexArray = vertexArrays[boundVertexArray];
+		for (int i = 0; i < MAX_ATTRIBUTES; i++)
+		{
+			const Attribute& attribute = vertexArray.attributes[i];
+			size_t elementSize = attribute.size * (attribute.type == GL_FLOAT ? 4 : 1);
+			if (attribute.enabled && (attribute.buffer == 0 || attribute.offset + (size_t)last * attribute.stride + elementSize > buffers[attribute.buffer - 1].size()))
+			{
+				std::cout << "ERROR::SOFTWARE_RASTERIZER::ATTRIBUTE_OUT_OF_RANGE " << i << std::endl;
+				return;
+			}
+		}
+		int attributeCount = 0;
+		for (int i = 0; i < MAX_ATTRIBUTES; i++)
+		{
+			attributeCount = vertexArray.attributes[i].enabled ? i + 1 : attributeCount;
+		}
+		size_t vertexCount = (size_t)last - first + 1;
+		std::vector<ClipVertex> vertices(vertexCount);
+		parallelFor(vertexCount, 1024, [&](size_t begin, size_t end, size_t)
+		{
+			for (size_t v = begin; v < end; v++)
+			{
+				Vec4 attributes[MAX_ATTRIBUTES];
+				fetch(vertexArray, attributeCount, first + (uint32_t)v, attributes);
+				Vec4 position = program->vertex(attributes, vertices[v].data + 4);
+				vertices[v].data[0] = position.x;
+				vertices[v].data[1] = position.y;
+				vertices[v].data[2] = position.z;
+				vertices[v].data[3] = position.w;
+			}
+		});
+		statistics.vertices += vertexCount;
+
+		// primitive assembly, clipping and setup, in chunks that keep the submission order
+		size_t primitives = mode == GL_TRIANGLES ? indices.size() / 3 : indices.size() - 2;
+		statistics.triangles += primitives;
+		size_t chunks = pool ? pool->getCount() * 4 : 1;
+		setups.resize(std::max(setups.size(), chunks));
+		for (SetupChunk& setup : setups)
+		{
+			setup.triangles.clear();
+			setup.planes.clear();
+		}
+		parallelFor(primitives, 256, [&](size_t begin, size_t end, size_t chunk)
+		{
+			for (size_t p = begin; p < end; p++)
+			{
+				uint32_t corner[3];
+				if (mode == GL_TRIANGLES)
+				{
+					corner[0] = indices[p * 3];
+					corner[1] = indices[p * 3 + 1];
+					corner[2] = indices[p * 3 + 2];
+				}
+				else if (mode == GL_TRIANGLE_STRIP)
+				{
+					// every other triangle is flipped back to the winding of the first
+					corner[0] = indices[p + (p & 1)];
+					corner[1] = indices[p + 1 - (p & 1)];
+					corner[2] = indices[p + 2];
+				}
+				else
+				{
+					corner[0] = indices[0];
+					corner[1] = indices[p + 1];
+					corner[2] = indices[p + 2];
+				}
+				const ClipVertex* triangle[3] = { &vertices[corner[0] - first], &vertices[corner[1] - first], &vertices[corner[2] - first] };
+				clip(triangle, setups[chunk]);
+			}
+		});
+
+		// binning in submission order, the chunks are consecutive ranges of primitives
+		for (std::vector<const Triangle*>& bin : bins)
+		{
+			bin.clear();
+		}
+		for (SetupChunk& setup : setups)
+		{
+			statistics.rasterized += setup.triangles.size();
+			for (Triangle& triangle : setup.triangles)
+			{
+				triangle.planes = (const float (*)[3])(setup.planes.data() + triangle.planeOffset);
+				for (int ty = triangle.minY / TILE_SIZE; ty <= triangle.maxY / TILE_SIZE; ty++)
+				{
+					for (int tx = triangle.minX / TILE_SIZE; tx <= triangle.maxX / TILE_SIZE; tx++)
+					{
+						bins[(size_t)ty * tilesX + tx].push_back(&triangle);
+					}
+				}
+			}
+		}
+		std::atomic<uint64_t> fragments(0);
+		parallelFor(bins.size(), 1, [&](size_t begin, size_t end, size_t)
+		{
+			uint64_t shaded = 0;
+			for (size_t tile = begin; tile < end; tile++)
+			{
+				for (const Triangle* triangle : bins[tile])
+				{
+					shaded += rasterize(*triangle, (int)(tile % tilesX) * TILE_SIZE, (int)(tile / tilesX) * TILE_SIZE);
+				}
+			}
+			fragments += shaded;
+		});
+		statistics.fragments += fragments;
+	}
+
+	// reads the attributes below count, the others keep their default
+	void fetch(const VertexArray& vertexArray, int count, uint32_t index, Vec4* attributes) const
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const Attribute& attribute = vertexArray.attributes[i];
+			attributes[i] = Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			if (!attribute.enabled)
+			{
+				continue;
+			}
+			const unsigned char* data = buffers[attribute.buffer - 1].data() + attribute.offset + (size_t)index * attribute.stride;
+			float* components = &attributes[i].x;
+			for (int c = 0; c < attribute.size; c++)
+			{
+				if (attribute.type == GL_FLOAT)
+				{
+					memcpy(&components[c], data + c * 4, 4);
+				}
+				else
+				{
+					components[c] = attribute.normalized ? data[c] / 255.0f : (float)data[c];
+				}
+			}
+		}
+	}
+
+	// signed distance of a clip position to a clip plane: near, far, then the guard band
+	float planeDistance(const float* position, int plane) const
+	{
+		switch (plane)
+		{
+		case 0:
+			return position[3] + position[2];
+		case 1:
+			return position[3] - position[2];
+		case 2:
+			return position[3] * bandX + position[0];
+		case 3:
+			return position[3] * bandX - position[0];
+		case 4:
+			return position[3] * bandY + position[1];
+		default:
+			return position[3] * bandY - position[1];
+		}
+	}
+
+	// clips a triangle against the planes its vertices cross (Sutherland-Hodgman), then sets up the fan
+	void clip(const ClipVertex* const* corners, SetupChunk& output) const
+	{
+		int components = 4 + program->varyings;
+		int outside[3] = {};
+		for (int v = 0; v < 3; v++)
+		{
+			for (int plane = 0; plane < 6; plane++)
+			{
+				outside[v] |= (planeDistance(corners[v]->data, plane) < 0.0f) << plane;
+			}
+		}
+		if (outside[0] & outside[1] & outside[2])
+		{
+			return;
+		}
+		if ((outside[0] | outside[1] | outside[2]) == 0)
+		{
+			setup(corners, output);
+			return;
+		}
+
+		ClipVertex buffer[2][MAX_CLIP_VERTICES];
+		int count = 3;
+		for (int v = 0; v < 3; v++)
+		{
+			memcpy(buffer[0][v].data, corners[v]->data, components * sizeof(float));
+		}
+		int current = 0;
+		int crossed = outside[0] | outside[1] | outside[2];
+		for (int plane = 0; plane < 6 && count >= 3; plane++)
+		{
+			if (!(crossed & (1 << plane)))
+			{
+				continue;
+			}
+			const ClipVertex* in = buffer[current];
+			ClipVertex* out = buffer[current ^ 1];
+			int kept = 0;
+			for (int v = 0; v < count; v++)
+			{
+				const ClipVertex& a = in[v];
+				const ClipVertex& b = in[(v + 1) % count];
+				float da = planeDistance(a.data, plane);
+				float db = planeDistance(b.data, plane);
+				if (da >= 0.0f)
+				{
+					out[kept++] = a;
+				}
+				if ((da >= 0.0f) != (db >= 0.0f))
+				{
+					float t = da / (da - db);
+					for (int c = 0; c < components; c++)
+					{
+						out[kept].data[c] = a.data[c] + (b.data[c] - a.data[c]) * t;
+					}
+					kept++;
+				}
+			}
+			count = kept;
+			current ^= 1;
+		}
+		for (int v = 1; v + 1 < count; v++)
+		{
+			const ClipVertex* fan[3] = { &buffer[current][0], &buffer[current][v], &buffer[current][v + 1] };
+			setup(fan, output);
+		}
+	}
+
+	// snaps a clipped triangle to the subpixel grid and builds its edge functions and planes
+	void setup(const ClipVertex* const* corners, SetupChunk& output) const
+	{
+		int32_t x[3];
+		int32_t y[3];
+		float invW[3];
+		for (int v = 0; v < 3; v++)
+		{
+			const float* position = corners[v]->data;
+			if (!(position[3] > 0.0f))
+			{
+				return;
+			}
+			invW[v] = 1.0f / position[3];
+			float windowX = view[0] + (position[0] * invW[v] + 1.0f) * 0.5f * view[2];
+			float windowY = view[1] + (position[1] * invW[v] + 1.0f) * 0.5f * view[3];
+			x[v] = (int32_t)std::floor(windowX * SUBPIXEL_ONE + 0.5f);
+			y[v] = (int32_t)std::floor(windowY * SUBPIXEL_ONE + 0.5f);
+		}
+		int order[3] = { 0, 1, 2 };
+		int64_t area = (int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (int64_t)(x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0)
+		{
+			return;
+		}
+		if (area < 0)
+		{
+			// no face culling: clockwise triangles are turned counter-clockwise
+			std::swap(order[1], order[2]);
+			area = -area;
+		}
+
+		Triangle triangle;
+		int32_t minX = INT32_MAX, minY = INT32_MAX, maxX = INT32_MIN, maxY = INT32_MIN;
+		for (int e = 0; e < 3; e++)
+		{
+			int i = order[e];
+			int j = order[(e + 1) % 3];
+			triangle.a[e] = y[i] - y[j];
+			triangle.b[e] = x[j] - x[i];
+			triangle.c[e] = -((int64_t)triangle.a[e] * x[i] + (int64_t)triangle.b[e] * y[i]);
+			// top-left rule: pixel centers exactly on an edge belong to the triangle on its left or top side
+			bool topLeft = triangle.a[e] > 0 || (triangle.a[e] == 0 && triangle.b[e] < 0);
+			if (!topLeft)
+			{
+				triangle.c[e] -= 1;
+			}
+			minX = std::min(minX, x[i]);
+			minY = std::min(minY, y[i]);
+			maxX = std::max(maxX, x[i]);
+			maxY = std::max(maxY, y[i]);
+		}
+		// pixels whose centers can be inside, within the viewport and the framebuffer
+		triangle.minX = std::max(FloorDivide((int64_t)minX - SUBPIXEL_ONE / 2 + SUBPIXEL_ONE - 1, SUBPIXEL_ONE), std::max(view[0], 0));
+		triangle.minY = std::max(FloorDivide((int64_t)minY - SUBPIXEL_ONE / 2 + SUBPIXEL_ONE - 1, SUBPIXEL_ONE), std::max(view[1], 0));
+		triangle.maxX = std::min(FloorDivide((int64_t)maxX - SUBPIXEL_ONE / 2, SUBPIXEL_ONE), std::min(view[0] + view[2], width) - 1);
+		triangle.maxY = std::min(FloorDivide((int64_t)maxY - SUBPIXEL_ONE / 2, SUBPIXEL_ONE), std::min(view[1] + view[3], height) - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		{
+			return;
+		}
+
+		// planes of 1/w and varying/w on the snapped positions, relative to the first vertex
+		double px[3], py[3];
+		for (int v = 0; v < 3; v++)
+		{
+			px[v] = (double)x[order[v]] / SUBPIXEL_ONE;
+			py[v] = (double)y[order[v]] / SUBPIXEL_ONE;
+		}
+		double dx1 = px[1] - px[0], dy1 = py[1] - py[0];
+		double dx2 = px[2] - px[0], dy2 = py[2] - py[0];
+		double inverseArea = 1.0 / (dx1 * dy2 - dx2 * dy1);
+		triangle.originX = (float)px[0];
+		triangle.originY = (float)py[0];
+		triangle.planeOffset = output.planes.size();
+		output.planes.resize(output.planes.size() + (program->varyings + 1) * 3);
+		float* planes = output.planes.data() + triangle.planeOffset;
+		for (int p = 0; p <= program->varyings; p++)
+		{
+			double f[3];
+			for (int v = 0; v < 3; v++)
+			{
+				f[v] = p == 0 ? invW[order[v]] : corners[order[v]]->data[4 + p - 1] * invW[order[v]];
+			}
+			planes[p * 3 + 0] = (float)f[0];
+			planes[p * 3 + 1] = (float)(((f[1] - f[0]) * dy2 - (f[2] - f[0]) * dy1) * inverseArea);
+			planes[p * 3 + 2] = (float)(((f[2] - f[0]) * dx1 - (f[1] - f[0]) * dx2) * inverseArea);
+		}
+		output.triangles.push_back(triangle);
+	}
+
+	// rasterizes the part of a triangle inside a tile, returns the number of shaded pixels
+	uint64_t rasterize(const Triangle& triangle, int tileX, int tileY)
+	{
+		int x0 = std::max(triangle.minX, tileX);
+		int y0 = std::max(triangle.minY, tileY);
+		int x1 = std::min(triangle.maxX, tileX + TILE_SIZE - 1);
+		int y1 = std::min(triangle.maxY, tileY + TILE_SIZE - 1);
+		if (x0 > x1 || y0 > y1)
+		{
+			return 0;
+		}
+
+		// edges fully outside the rectangle reject it, fully inside ones are skipped;
+		// the others cross it, so their values in the rectangle fit 32 bits
+		int32_t start[3];
+		int32_t stepX[3];
+		int32_t stepY[3];
+		for (int e = 0; e < 3; e++)
+		{
+			int64_t corners[4];
+			for (int k = 0; k < 4; k++)
+			{
+				int64_t cx = (int64_t)(k & 1 ? x1 : x0) * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+				int64_t cy = (int64_t)(k & 2 ? y1 : y0) * SUBPIXEL_ONE + SUBPIXEL_ONE / 2;
+				corners[k] = triangle.a[e] * cx + triangle.b[e] * cy + triangle.c[e];
+			}
+			int64_t lowest = std::min(std::min(corners[0], corners[1]), std::min(corners[2], corners[3]));
+			int64_t highest = std::max(std::max(corners[0], corners[1]), std::max(corners[2], corners[3]));
+			if (highest < 0)
+			{
+				return 0;
+			}
+			bool inside = lowest >= 0;
+			start[e] = inside ? 0 : (int32_t)corners[0];
+			stepX[e] = inside ? 0 : triangle.a[e] * SUBPIXEL_ONE;
+			stepY[e] = inside ? 0 : triangle.b[e] * SUBPIXEL_ONE;
+		}
+
+		// lowest covered lane of a coverage mask
+		static const int8_t lowest[16] = { 0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0 };
+		// 8x8 blocks: the extremes of an edge over a block are at its corners, so a block is
+		// skipped when an edge is negative everywhere and shaded without tests when all are positive
+		uint64_t shaded = 0;
+		for (int blockY = y0; blockY <= y1; blockY = (blockY | (BLOCK_SIZE - 1)) + 1)
+		{
+			int blockY1 = std::min(blockY | (BLOCK_SIZE - 1), y1);
+			for (int blockX = x0; blockX <= x1; blockX = (blockX | (BLOCK_SIZE - 1)) + 1)
+			{
+				int blockX1 = std::min(blockX | (BLOCK_SIZE - 1), x1);
+				int32_t row[3];
+				bool outside = false;
+				bool covered = true;
+				for (int e = 0; e < 3; e++)
+				{
+					row[e] = start[e] + stepX[e] * (blockX - x0) + stepY[e] * (blockY - y0);
+					int32_t spanX = stepX[e] * (blockX1 - blockX);
+					int32_t spanY = stepY[e] * (blockY1 - blockY);
+					outside = outside || row[e] + std::max(spanX, 0) + std::max(spanY, 0) < 0;
+					covered = covered && row[e] + std::min(spanX, 0) + std::min(spanY, 0) >= 0;
+				}
+				if (outside)
+				{
+					continue;
+				}
+				if (covered)
+				{
+					for (int y = blockY; y <= blockY1; y++)
+					{
+						for (int x = blockX; x <= blockX1; x++)
+						{
+							shade(triangle, x, y);
+						}
+					}
+					shaded += (uint64_t)(blockX1 - blockX + 1) * (blockY1 - blockY + 1);
+					continue;
+				}
+				for (int y = blockY; y <= blockY1; y++)
+				{
+					for (int x = blockX; x <= blockX1; x += 4)
+					{
+						// bit i set when pixel x + i is covered
+						int mask = coverage(row, stepX, x - blockX) & ((1 << std::min(4, blockX1 - x + 1)) - 1);
+						while (mask)
+						{
+							shade(triangle, x + lowest[mask], y);
+							mask &= mask - 1;
+							shaded++;
+						}
+					}
+					for (int e = 0; e < 3; e++)
+					{
+						row[e] += stepY[e];
+					}
+				}
+			}
+		}
+		return shaded;
+	}
+
+	// coverage of 4 pixels of a row starting offset pixels after the row values
+	static int coverage(const int32_t* row, const int32_t* stepX, int offset)
+	{
+#if defined(SOFTWARE_RASTERIZER_SSE2)
+		__m128i any = _mm_setzero_si128();
+		for (int e = 0; e < 3; e++)
+		{
+			int32_t base = row[e] + stepX[e] * offset;
+			__m128i values = _mm_add_epi32(_mm_set1_epi32(base), _mm_setr_epi32(0, stepX[e], stepX[e] * 2, stepX[e] * 3));
+			any = _mm_or_si128(any, values);
+		}
+		// a negative edge value sets the sign bit
+		return ~_mm_movemask_ps(_mm_castsi128_ps(any)) & 0xF;
+#elif defined(SOFTWARE_RASTERIZER_NEON)
+		uint32x4_t any = vdupq_n_u32(0);
+		static const int32_t lanes[4] = { 0, 1, 2, 3 };
+		int32x4_t lane = vld1q_s32(lanes);
+		for (int e = 0; e < 3; e++)
+		{
+			int32x4_t values = vmlaq_n_s32(vdupq_n_s32(row[e] + stepX[e] * offset), lane, stepX[e]);
+			any = vorrq_u32(any, vreinterpretq_u32_s32(values));
+		}
+		uint32x4_t sign = vshrq_n_u32(any, 31);
+		return (int)(~(vgetq_lane_u32(sign, 0) | vgetq_lane_u32(sign, 1) << 1 | vgetq_lane_u32(sign, 2) << 2 | vgetq_lane_u32(sign, 3) << 3) & 0xF);
+#else
+		int covered = 0;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			bool inside = true;
+			for (int e = 0; e < 3; e++)
+			{
+				inside = inside && row[e] + stepX[e] * (offset + lane) >= 0;
+			}
+			covered |= inside << lane;
+		}
+		return covered;
+#endif
+	}
+
+	void shade(const Triangle& triangle, int x, int y)
+	{
+		SoftwareFragment fragment;
+		fragment.x = x + 0.5f;
+		fragment.y = y + 0.5f;
+		float dx = fragment.x - triangle.originX;
+		float dy = fragment.y - triangle.originY;
+		float invW = triangle.planes[0][0] + triangle.planes[0][1] * dx + triangle.planes[0][2] * dy;
+		fragment.w = 1.0f / invW;
+		for (int i = 0; i < program->varyings; i++)
+		{
+			const float* plane = triangle.planes[i + 1];
+			fragment.varyings[i] = (plane[0] + plane[1] * dx + plane[2] * dy) * fragment.w;
+		}
+		fragment.planes = triangle.planes;
+		colorBuffer[(size_t)y * width + x] = Pack(program->fragment(fragment));
+	}
+};
+
+#endif // !SOFTWARE_RASTERIZER_H
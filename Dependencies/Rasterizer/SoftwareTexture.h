@@ -0,0 +1,259 @@
+#ifndef SOFTWARE_TEXTURE_H
+#define SOFTWARE_TEXTURE_H
+
+#include <glad/glad.h> // GL enums and types only, no GL function is called
+
+#include <MipGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/// <summary>
+/// Four floats: clip positions, vertex attributes and colors of the software rasterizer
+/// </summary>
+struct Vec4
+{
+	float x = 0.0f;
+	float y = 0.0f;
+	float z = 0.0f;
+	float w = 1.0f;
+
+	Vec4() = default;
+
+	Vec4(float x, float y, float z, float w)
+		: x(x), y(y), z(z), w(w)
+	{
+	}
+
+	Vec4 operator*(const Vec4& other) const
+	{
+		return Vec4(x * other.x, y * other.y, z * other.z, w * other.w);
+	}
+};
+
+/// <summary>
+/// Input of a fragment shader: the varyings of the vertex shader interpolated at a pixel center,
+/// perspective correct, and their screen space derivatives (what dFdx/dFdy return in GLSL)
+/// </summary>
+struct SoftwareFragment
+{
+	static const int MAX_VARYINGS = 16;
+
+	// window coordinates of the pixel center
+	float x;
+	float y;
+	float varyings[MAX_VARYINGS];
+
+	float dFdx(int varying) const
+	{
+		return (planes[varying + 1][1] - varyings[varying] * planes[0][1]) * w;
+	}
+
+	float dFdy(int varying) const
+	{
+		return (planes[varying + 1][2] - varyings[varying] * planes[0][2]) * w;
+	}
+
+	// interpolation planes of the triangle: 1/w then every varying/w, value and x/y gradients
+	const float (*planes)[3];
+	float w;
+};
+
+/// <summary>
+/// RGBA8 2D texture sampled by software fragment shaders, with the filters, mipmaps
+/// and wrap modes of GL_TEXTURE_2D and the same defaults (GL_NEAREST_MIPMAP_LINEAR, GL_REPEAT)
+/// </summary>
+class SoftwareTexture
+{
+public:
+	/// <summary>
+	/// Sets level 0 from 8 bit pixels, the first row is at t = 0 like glTexImage2D; the mipmaps are dropped
+	/// </summary>
+	/// <param name="width">Width of the image</param>
+	/// <param name="height">Height of the image</param>
+	/// <param name="channels">1 to 4, missing channels read as 0 and alpha as 1</param>
+	/// <param name="pixels">Rows tightly packed</param>
+	void image(int width, int height, int channels, const unsigned char* pixels)
+	{
+		levels.assign(1, MipLevel());
+		MipLevel& level = levels[0];
+		level.width = width;
+		level.height = height;
+		level.pixels.resize((size_t)width * height * 4);
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			unsigned char* texel = &level.pixels[i * 4];
+			const unsigned char* pixel = pixels + i * channels;
+			texel[0] = pixel[0];
+			texel[1] = channels > 1 ? pixel[1] : 0;
+			texel[2] = channels > 2 ? pixel[2] : 0;
+			texel[3] = channels > 3 ? pixel[3] : 255;
+		}
+	}
+
+	/// <summary>
+	/// Builds the mip chain from level 0 with a box filter, like glGenerateMipmap
+	/// </summary>
+	void generateMipmap()
+	{
+		if (!levels.empty())
+		{
+			levels = MipGenerator::Generate(levels[0].pixels.data(), levels[0].width, levels[0].height, 4);
+		}
+	}
+
+	/// <summary>
+	/// Sets GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S or GL_TEXTURE_WRAP_T
+	/// </summary>
+	void parameter(GLenum name, GLint value)
+	{
+		switch (name)
+		{
+		case GL_TEXTURE_MIN_FILTER:
+			minFilter = value;
+			break;
+		case GL_TEXTURE_MAG_FILTER:
+			magFilter = value;
+			break;
+		case GL_TEXTURE_WRAP_S:
+			wrap[0] = value;
+			break;
+		case GL_TEXTURE_WRAP_T:
+			wrap[1] = value;
+			break;
+		}
+	}
+
+	/// <summary>
+	/// Samples at a level of detail, as textureLod()
+	/// </summary>
+	Vec4 sample(float s, float t, float lod) const
+	{
+		if (levels.empty())
+		{
+			return Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		if (lod <= 0.0f)
+		{
+			return filter(levels[0], s, t, magFilter == GL_LINEAR);
+		}
+		bool linear = minFilter == GL_LINEAR || minFilter == GL_LINEAR_MIPMAP_NEAREST || minFilter == GL_LINEAR_MIPMAP_LINEAR;
+		if (minFilter == GL_NEAREST || minFilter == GL_LINEAR)
+		{
+			return filter(levels[0], s, t, linear);
+		}
+		float last = (float)(levels.size() - 1);
+		if (minFilter == GL_NEAREST_MIPMAP_NEAREST || minFilter == GL_LINEAR_MIPMAP_NEAREST)
+		{
+			int level = (int)std::min(std::max(std::ceil(lod + 0.5f) - 1.0f, 0.0f), last);
+			return filter(levels[level], s, t, linear);
+		}
+		lod = std::min(lod, last);
+		int level = (int)lod;
+		Vec4 a = filter(levels[level], s, t, linear);
+		if (level == (int)last)
+		{
+			return a;
+		}
+		Vec4 b = filter(levels[level + 1], s, t, linear);
+		float f = lod - level;
+		return Vec4(a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f, a.z + (b.z - a.z) * f, a.w + (b.w - a.w) * f);
+	}
+
+	/// <summary>
+	/// Samples with the level of detail of the pixel, as texture(): the coordinates are
+	/// two consecutive varyings of the fragment, their derivatives give the footprint
+	/// </summary>
+	/// <param name="fragment">Fragment being shaded</param>
+	/// <param name="coordinates">Index of the s varying, t is the next one</param>
+	Vec4 sample(const SoftwareFragment& fragment, int coordinates) const
+	{
+		if (levels.empty())
+		{
+			return Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		float width = (float)levels[0].width;
+		float height = (float)levels[0].height;
+		float dsdx = fragment.dFdx(coordinates) * width;
+		float dtdx = fragment.dFdx(coordinates + 1) * height;
+		float dsdy = fragment.dFdy(coordinates) * width;
+		float dtdy = fragment.dFdy(coordinates + 1) * height;
+		float rho = std::max(dsdx * dsdx + dtdx * dtdx, dsdy * dsdy + dtdy * dtdy);
+		// log2(sqrt(rho)), -inf for a constant coordinate is magnification
+		float lod = rho > 0.0f ? 0.5f * std::log2(rho) : -1.0f;
+		return sample(fragment.varyings[coordinates], fragment.varyings[coordinates + 1], lod);
+	}
+
+	int getWidth() const
+	{
+		return levels.empty() ? 0 : levels[0].width;
+	}
+
+	int getHeight() const
+	{
+		return levels.empty() ? 0 : levels[0].height;
+	}
+
+	int getLevelCount() const
+	{
+		return (int)levels.size();
+	}
+
+private:
+	std::vector<MipLevel> levels;
+	GLint minFilter = GL_NEAREST_MIPMAP_LINEAR;
+	GLint magFilter = GL_LINEAR;
+	GLint wrap[2] = { GL_REPEAT, GL_REPEAT };
+
+	static int Wrap(int coordinate, int size, GLint mode)
+	{
+		switch (mode)
+		{
+		case GL_CLAMP_TO_EDGE:
+			return std::min(std::max(coordinate, 0), size - 1);
+		case GL_MIRRORED_REPEAT:
+		{
+			int period = coordinate >= 0 ? coordinate % (2 * size) : (2 * size - 1) - (-coordinate - 1) % (2 * size);
+			return period < size ? period : 2 * size - 1 - period;
+		}
+		default:
+			return coordinate >= 0 ? coordinate % size : (size - 1) - (-coordinate - 1) % size;
+		}
+	}
+
+	Vec4 fetch(const MipLevel& level, int x, int y) const
+	{
+		const unsigned char* texel = &level.pixels[((size_t)Wrap(y, level.height, wrap[1]) * level.width + Wrap(x, level.width, wrap[0])) * 4];
+		return Vec4(texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f, texel[3] / 255.0f);
+	}
+
+	Vec4 filter(const MipLevel& level, float s, float t, bool linear) const
+	{
+		float u = s * level.width;
+		float v = t * level.height;
+		if (!linear)
+		{
+			return fetch(level, (int)std::floor(u), (int)std::floor(v));
+		}
+		u -= 0.5f;
+		v -= 0.5f;
+		float x0 = std::floor(u);
+		float y0 = std::floor(v);
+		float fx = u - x0;
+		float fy = v - y0;
+		Vec4 a = fetch(level, (int)x0, (int)y0);
+		Vec4 b = fetch(level, (int)x0 + 1, (int)y0);
+		Vec4 c = fetch(level, (int)x0, (int)y0 + 1);
+		Vec4 d = fetch(level, (int)x0 + 1, (int)y0 + 1);
+		float wa = (1.0f - fx) * (1.0f - fy);
+		float wb = fx * (1.0f - fy);
+		float wc = (1.0f - fx) * fy;
+		float wd = fx * fy;
+		return Vec4(a.x * wa + b.x * wb + c.x * wc + d.x * wd, a.y * wa + b.y * wb + c.y * wc + d.y * wd,
+			a.z * wa + b.z * wb + c.z * wc + d.z * wd, a.w * wa + b.w * wb + c.w * wc + d.w * wd);
+	}
+};
+
+#endif // !SOFTWARE_TEXTURE_H
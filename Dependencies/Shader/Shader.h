@@ -2,12 +2,43 @@
 #define SHADER_H
 
 #include <glad/glad.h> // include glad to get all the required OpenGL headers
+#include <CpuProfiler.h>
+#include <ShaderCache.h>
+#include <ShaderPreprocessor.h>
+#include <ShaderSource.h>
 
+#include <cstdint>
+#include <cstring>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <utility>
+#include <vector>
 #include <iostream>
 
+/// <summary>
+/// Location of a uniform resolved once at link time, setting it needs no lookup
+/// </summary>
+struct UniformHandle
+{
+	GLint location = -1;
+
+	bool isValid() const
+	{
+		return location >= 0;
+	}
+};
+
+/// <summary>
+/// When the compile and link status of a program is checked
+/// </summary>
+enum class ShaderCompile
+{
+	// wait for the driver in the constructor
+	Blocking,
+	// submit the work and wait only on first use (or finish()),
+	// so many programs compile in parallel with KHR_parallel_shader_compile
+	Deferred
+};
+
 class Shader
 {
 public:
@@ -16,97 +47,267 @@ public:
 	/// </summary>
 	/// <param name="vertexPath">Vertex shader file path</param>
 	/// <param name="fragmentPath">Fragment shader file path</param>
-	Shader(const char* vertexPath, const char* fragmentPath)
-	{
-		// code taken from the file as a string
-		std::string vertexCode;			
-		std::string fragmentCode;
-		// file stream from wich load the code
-		std::ifstream vShaderFile;		 
-		std::ifstream fShaderFile;
-
-		// check if the ifstram can throw exceptions:
-		vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-		// try open vert and frag files and store the code
-		try
-		{
-			// open file
-			vShaderFile.open(vertexPath);
-			fShaderFile.open(fragmentPath);
-			// create a stream buffer
-			std::stringstream vShaderStream, fShaderStream; // buffer that contains a sequence of characters
-			// read the text from the files and put it into the two streams
-			vShaderStream << vShaderFile.rdbuf();
-			fShaderStream << fShaderFile.rdbuf();
-			// close the files just opened
-			vShaderFile.close();
-			fShaderFile.close();
-			// convert the stream (sequence o chars) into a string
-			vertexCode = vShaderStream.str();
-			fragmentCode = fShaderStream.str();
-		}
-		catch (std::ifstream::failure e)
-		{
-			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-		}
-
-		// convert string to char*
-		const char* vShaderCode = vertexCode.c_str();
-		const char* fShaderCode = fragmentCode.c_str();
-
-		// 2. compile shaders
-		unsigned int vertex, fragment;
-		int success;
-		char infoLog[512];
+	/// <param name="compile">Wait for the compilation now or on first use</param>
+	Shader(const char* vertexPath, const char* fragmentPath, ShaderCompile compile = ShaderCompile::Blocking)
+		: Shader(vertexPath, fragmentPath, std::vector<std::string>(), compile)
+	{
+	}
 
-		// vertex Shader
-		vertex = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex, 1, &vShaderCode, NULL);
-		glCompileShader(vertex);
-		checkCompileErrors(vertex, "VERTEX");
+	/// <summary>
+	/// Shader class that handles shader loading and compiling, with #define feature flags
+	/// </summary>
+	/// <param name="vertexPath">Vertex shader file path</param>
+	/// <param name="fragmentPath">Fragment shader file path</param>
+	/// <param name="defines">Defines injected in both stages, e.g. "USE_TEXTURE"</param>
+	/// <param name="compile">Wait for the compilation now or on first use</param>
+	Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines, ShaderCompile compile = ShaderCompile::Blocking)
+		: ID(0)
+	{
+		// 1. map the files and resolve the #includes, the content goes to the driver without being copied
+		ShaderSource vertexSource, fragmentSource;
+		ShaderPreprocessor::Expand(vertexPath, defines, vertexSource);
+		ShaderPreprocessor::Expand(fragmentPath, defines, fragmentSource);
 
-		// fragment shader
-		fragment = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment, 1, &fShaderCode, NULL);
-		glCompileShader(fragment);
-		checkCompileErrors(fragment, "FRAGMENT");
+		// 2. compile and link (or load the cached binary)
+		submit(vertexSource, fragmentSource);
+		if (compile == ShaderCompile::Blocking)
+		{
+			finish();
+		}
+	}
 
-		// shader Program
-		ID = glCreateProgram();
-		glAttachShader(ID, vertex);
-		glAttachShader(ID, fragment);
-		glLinkProgram(ID);
-		checkCompileErrors(ID, "PROGRAM");
+	/// <summary>
+	/// Builds a program from sources made of several pieces (e.g. expanded #includes)
+	/// </summary>
+	/// <param name="vertexSource">Vertex shader source</param>
+	/// <param name="fragmentSource">Fragment shader source</param>
+	/// <param name="compile">Wait for the compilation now or on first use</param>
+	Shader(const ShaderSource& vertexSource, const ShaderSource& fragmentSource, ShaderCompile compile = ShaderCompile::Blocking)
+		: ID(0)
+	{
+		submit(vertexSource, fragmentSource);
+		if (compile == ShaderCompile::Blocking)
+		{
+			finish();
+		}
+	}
+
+	/// <summary>
+	/// Submits the compilation of many programs before waiting on any of them
+	/// </summary>
+	/// <param name="paths">Vertex and fragment shader file paths of each program</param>
+	/// <returns>Deferred shaders, each one blocks on first use if not ready yet</returns>
+	static std::vector<Shader> CompileAll(const std::vector<std::pair<std::string, std::string>>& paths)
+	{
+		std::vector<Shader> shaders;
+		shaders.reserve(paths.size());
+		for (const auto& program : paths)
+		{
+			shaders.emplace_back(program.first.c_str(), program.second.c_str(), ShaderCompile::Deferred);
+		}
+		return shaders;
+	}
 
-		// delete the shaders as they're linked into our program now and no longer necessary
-		glDeleteShader(vertex);
-		glDeleteShader(fragment);
+	/// <summary>
+	/// Empty shader that owns no program
+	/// </summary>
+	Shader() : ID(0)
+	{
 	}
 
 	~Shader()
 	{
+		releaseStages();
 		// delete the program on destruction
-		glDeleteProgram(ID);
+		if (ID)
+		{
+			glDeleteProgram(ID);
+		}
+	}
+
+	// the program is owned by exactly one Shader: copies would delete it twice
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
+	Shader(Shader&& other) noexcept
+		: ID(other.ID), linked(other.linked), uniforms(std::move(other.uniforms)), pending(other.pending)
+	{
+		other.ID = 0;
+		other.linked = false;
+		other.uniforms.clear();
+		other.pending = Pending();
+	}
+
+	Shader& operator=(Shader&& other) noexcept
+	{
+		if (this != &other)
+		{
+			releaseStages();
+			if (ID)
+			{
+				glDeleteProgram(ID);
+			}
+			ID = other.ID;
+			linked = other.linked;
+			uniforms = std::move(other.uniforms);
+			pending = other.pending;
+			other.ID = 0;
+			other.linked = false;
+			other.uniforms.clear();
+			other.pending = Pending();
+		}
+		return *this;
+	}
+
+	/// <summary>
+	/// Gives up ownership of the program without deleting it
+	/// </summary>
+	/// <returns>The program ID, the caller has to delete it</returns>
+	GLuint release()
+	{
+		finish();
+		GLuint program = ID;
+		ID = 0;
+		linked = false;
+		uniforms.clear();
+		return program;
+	}
+
+	/// <summary>
+	/// Takes ownership of an already linked program, the current one is deleted
+	/// </summary>
+	/// <param name="program">Program ID</param>
+	void adopt(GLuint program)
+	{
+		releaseStages();
+		if (ID && ID != program)
+		{
+			glDeleteProgram(ID);
+		}
+		ID = program;
+		GLint success = 0;
+		if (ID)
+		{
+			glGetProgramiv(ID, GL_LINK_STATUS, &success);
+		}
+		linked = success != 0;
+		loadUniforms();
 	}
 
 	/// <summary>
 	/// Returns the shader's program ID
 	/// </summary>
-	GLuint getID()
+	GLuint getID() const
 	{
 		return ID;
 	}
 
+	/// <summary>
+	/// Returns false while a deferred compilation is still running in the driver.
+	/// Never blocks: without KHR_parallel_shader_compile it is always true.
+	/// </summary>
+	bool isReady() const
+	{
+		if (!pending.active || !GLExt::parallelShaderCompile)
+		{
+			return true;
+		}
+		GLint done = GL_FALSE;
+		glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+		return done == GL_TRUE;
+	}
+
+	/// <summary>
+	/// Waits for a deferred compilation, checks the errors and reads the uniforms
+	/// </summary>
+	void finish() const
+	{
+		if (!pending.active)
+		{
+			return;
+		}
+		PROFILE_SCOPE("shader finish");
+		checkCompileErrors(pending.vertex, "VERTEX");
+		checkCompileErrors(pending.fragment, "FRAGMENT");
+		linked = checkCompileErrors(ID, "PROGRAM");
+		if (linked && pending.cached)
+		{
+			ShaderCache::Store(ID, pending.cacheKey);
+		}
+		releaseStages();
+		loadUniforms();
+	}
+
+	/// <summary>
+	/// Returns true if the program linked successfully, waits for a deferred compilation
+	/// </summary>
+	bool isLinked() const
+	{
+		finish();
+		return linked;
+	}
+
 	/// <summary>
 	/// Enables the shader in the current context
 	/// </summary>
-	void use()
+	void use() const
 	{
+		finish();
 		glUseProgram(ID);
 	}
 
+	/// <summary>
+	/// FNV-1a hash of a uniform name, usable at compile time
+	/// </summary>
+	/// <param name="name">Name of the uniform</param>
+	static constexpr uint32_t Hash(const char* name)
+	{
+		uint32_t hash = 2166136261u;
+		while (*name)
+		{
+			hash = (hash ^ (unsigned char)*name++) * 16777619u;
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Returns the handle of an active uniform, invalid if the program doesn't use it
+	/// </summary>
+	/// <param name="name">Name of the uniform</param>
+	UniformHandle getUniform(const char* name) const
+	{
+		return getUniform(Hash(name), name);
+	}
+
+	/// <summary>
+	/// Returns the handle of an active uniform from a precomputed name hash
+	/// </summary>
+	/// <param name="hash">Shader::Hash of the name</param>
+	/// <param name="name">Name of the uniform</param>
+	UniformHandle getUniform(uint32_t hash, const char* name) const
+	{
+		finish();
+		UniformHandle handle;
+		if (!uniforms.empty())
+		{
+			size_t mask = uniforms.size() - 1;
+			for (size_t i = hash & mask; uniforms[i].location >= 0; i = (i + 1) & mask)
+			{
+				if (uniforms[i].hash == hash && uniforms[i].name == name)
+				{
+					handle.location = uniforms[i].location;
+					return handle;
+				}
+			}
+		}
+		// single array elements ("name[2]") are not in the table, ask the driver
+		if (strchr(name, '['))
+		{
+			handle.location = glGetUniformLocation(ID, name);
+		}
+		return handle;
+	}
+
 	/// <summary>
 	/// Sets a bool uniform
 	/// </summary>
@@ -114,7 +315,17 @@ public:
 	/// <param name="value">New value</param>
 	void setBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		setBool(getUniform(name.c_str()), value);
+	}
+
+	/// <summary>
+	/// Sets a bool uniform
+	/// </summary>
+	/// <param name="uniform">Handle of the uniform</param>
+	/// <param name="value">New value</param>
+	void setBool(UniformHandle uniform, bool value) const
+	{
+		glUniform1i(uniform.location, (int)value);
 	}
 
 	/// <summary>
@@ -124,7 +335,17 @@ public:
 	/// <param name="value">New value</param>
 	void setInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		setInt(getUniform(name.c_str()), value);
+	}
+
+	/// <summary>
+	/// Sets an Int uniform
+	/// </summary>
+	/// <param name="uniform">Handle of the uniform</param>
+	/// <param name="value">New value</param>
+	void setInt(UniformHandle uniform, int value) const
+	{
+		glUniform1i(uniform.location, value);
 	}
 
 	/// <summary>
@@ -134,15 +355,171 @@ public:
 	/// <param name="value">New value</param>
 	void setFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		setFloat(getUniform(name.c_str()), value);
+	}
+
+	/// <summary>
+	/// Sets a Float uniform
+	/// </summary>
+	/// <param name="uniform">Handle of the uniform</param>
+	/// <param name="value">New value</param>
+	void setFloat(UniformHandle uniform, float value) const
+	{
+		glUniform1f(uniform.location, value);
 	}
 
 private:
 	GLuint ID;
+	mutable bool linked = false;
+
+	// active uniforms of the program: open addressing table indexed by name hash,
+	// empty slots have location -1
+	struct UniformEntry
+	{
+		uint32_t hash = 0;
+		GLint location = -1;
+		std::string name;
+	};
+	// filled on first use for deferred shaders
+	mutable std::vector<UniformEntry> uniforms;
+
+	// stages of a submitted compilation whose status wasn't checked yet
+	struct Pending
+	{
+		bool active = false;
+		bool cached = false;
+		uint64_t cacheKey = 0;
+		GLuint vertex = 0;
+		GLuint fragment = 0;
+	};
+	mutable Pending pending;
+
+	// start compiling and linking the program, going through the binary cache when enabled.
+	// Nothing here waits for the driver: the status is checked in finish()
+	// ------------------------------------------------------------------------
+	void submit(const ShaderSource& vertexSource, const ShaderSource& fragmentSource)
+	{
+		PROFILE_SCOPE("shader submit");
+		bool cached = ShaderCache::IsEnabled();
+		uint64_t cacheKey = 0;
+		if (cached)
+		{
+			const ShaderSource* sources[] = { &vertexSource, &fragmentSource };
+			cacheKey = ShaderCache::Key(sources, 2);
+		}
+		if (cached)
+		{
+			ID = ShaderCache::Load(cacheKey);
+			if (ID)
+			{
+				linked = true;
+				loadUniforms();
+				return;
+			}
+		}
+
+		// vertex Shader
+		pending.vertex = glCreateShader(GL_VERTEX_SHADER);
+		vertexSource.upload(pending.vertex);
+		glCompileShader(pending.vertex);
+
+		// fragment shader
+		pending.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+		fragmentSource.upload(pending.fragment);
+		glCompileShader(pending.fragment);
+
+		// shader Program
+		ID = glCreateProgram();
+		glAttachShader(ID, pending.vertex);
+		glAttachShader(ID, pending.fragment);
+		if (cached)
+		{
+			GLExt::ProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(ID);
+
+		pending.active = true;
+		pending.cached = cached;
+		pending.cacheKey = cacheKey;
+	}
+
+	// delete the shaders as they're linked into our program now and no longer necessary
+	void releaseStages() const
+	{
+		if (!pending.active)
+		{
+			return;
+		}
+		glDeleteShader(pending.vertex);
+		glDeleteShader(pending.fragment);
+		pending = Pending();
+	}
+
+	// introspect the active uniforms once after linking
+	// ------------------------------------------------------------------------
+	void loadUniforms() const
+	{
+		uniforms.clear();
+		if (!ID)
+		{
+			return;
+		}
+		GLint count = 0, maxLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		if (count <= 0)
+		{
+			return;
+		}
+
+		// arrays take two slots: keep the load factor under 1/2 so probing stays short
+		size_t capacity = 1;
+		while (capacity < (size_t)count * 4)
+		{
+			capacity <<= 1;
+		}
+		uniforms.resize(capacity);
+
+		std::vector<char> nameBuffer(maxLength > 0 ? maxLength : 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+			std::string name(nameBuffer.data(), length);
+			GLint location = glGetUniformLocation(ID, name.c_str());
+			// uniforms inside blocks have no location
+			if (location < 0)
+			{
+				continue;
+			}
+			// arrays are reported as "name[0]", make them reachable as "name" too
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			{
+				insertUniform(name.substr(0, name.size() - 3), location);
+			}
+			insertUniform(name, location);
+		}
+	}
+
+	void insertUniform(const std::string& name, GLint location) const
+	{
+		uint32_t hash = Hash(name.c_str());
+		size_t mask = uniforms.size() - 1;
+		size_t i = hash & mask;
+		while (uniforms[i].location >= 0)
+		{
+			i = (i + 1) & mask;
+		}
+		uniforms[i].hash = hash;
+		uniforms[i].location = location;
+		uniforms[i].name = name;
+	}
 
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
-	void checkCompileErrors(unsigned int shader, std::string type)
+	bool checkCompileErrors(unsigned int shader, std::string type) const
 	{
 		int success;
 		char infoLog[1024];
@@ -164,6 +541,7 @@ private:
 				std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
 			}
 		}
+		return success != 0;
 	}
 };
 
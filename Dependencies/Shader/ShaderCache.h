@@ -0,0 +1,200 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+#include <GLExt.h>
+#include <ShaderSource.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+/// Entries are keyed by the shader sources and by the driver that produced them,
+/// a driver update or a format mismatch simply falls back to compiling.
+/// </summary>
+class ShaderCache
+{
+public:
+	/// <summary>
+	/// Enables the cache in the given directory, an empty path disables it
+	/// </summary>
+	/// <param name="path">Cache directory, created if missing</param>
+	static void SetDirectory(const std::string& path)
+	{
+		directory = path;
+		if (!directory.empty())
+		{
+			std::error_code error;
+			std::filesystem::create_directories(directory, error);
+		}
+	}
+
+	/// <summary>
+	/// Returns true if the cache is enabled and the driver can save program binaries
+	/// </summary>
+	static bool IsEnabled()
+	{
+		if (directory.empty() || !GLExt::GetProgramBinary || !GLExt::ProgramBinary)
+		{
+			return false;
+		}
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		return formats > 0;
+	}
+
+	/// <summary>
+	/// Hashes the program sources together with the vendor, renderer and driver version
+	/// </summary>
+	/// <param name="sources">Source of every stage (defines included)</param>
+	/// <param name="count">Number of stages</param>
+	static uint64_t Key(const ShaderSource* const* sources, size_t count)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		const GLenum driver[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (GLenum name : driver)
+		{
+			const char* value = (const char*)glGetString(name);
+			hash = Separate(Hash(hash, value, value ? strlen(value) : 0));
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			// the pieces of a stage hash like their concatenation
+			for (size_t piece = 0; piece < sources[i]->getCount(); piece++)
+			{
+				hash = Hash(hash, sources[i]->getString(piece), sources[i]->getLength(piece));
+			}
+			hash = Separate(hash);
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Creates a program from the cached binary
+	/// </summary>
+	/// <param name="key">Cache key</param>
+	/// <returns>The linked program, 0 if there is no valid entry</returns>
+	static GLuint Load(uint64_t key)
+	{
+		std::ifstream file(path(key), std::ios::binary);
+		if (!file)
+		{
+			return 0;
+		}
+
+		Header header;
+		if (!file.read((char*)&header, sizeof(header)) || header.magic != MAGIC || header.key != key)
+		{
+			return 0;
+		}
+		// a truncated or corrupt entry must not allocate more than the file holds
+		std::streampos dataStart = file.tellg();
+		file.seekg(0, std::ios::end);
+		std::streamoff remaining = file.tellg() - dataStart;
+		file.seekg(dataStart);
+		if (!file || remaining != (std::streamoff)header.length)
+		{
+			return 0;
+		}
+		std::vector<char> binary(header.length);
+		if (!file.read(binary.data(), binary.size()))
+		{
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		GLExt::ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+		GLint success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		if (!success)
+		{
+			// the driver changed its binary format: recompile and overwrite the entry
+			std::cout << "LOG::SHADER_CACHE::STALE_ENTRY " << path(key) << std::endl;
+			glDeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	/// <summary>
+	/// Saves the binary of a linked program, the program should have been linked
+	/// with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	/// </summary>
+	/// <param name="program">Linked program</param>
+	/// <param name="key">Cache key</param>
+	static void Store(GLuint program, uint64_t key)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+		{
+			return;
+		}
+
+		Header header;
+		header.key = key;
+		std::vector<char> binary(length);
+		GLsizei written = 0;
+		GLExt::GetProgramBinary(program, length, &written, &header.format, binary.data());
+		header.length = (uint32_t)written;
+
+		// write to a temporary file first so a crash never leaves a truncated entry
+		std::string target = path(key);
+		std::string temporary = target + ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			if (!file.write((const char*)&header, sizeof(header)) || !file.write(binary.data(), written))
+			{
+				std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED " << target << std::endl;
+				return;
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(temporary, target, error);
+	}
+
+private:
+	static constexpr uint32_t MAGIC = 0x4C4F4753; // "SGOL"
+
+	struct Header
+	{
+		uint32_t magic = MAGIC;
+		GLenum format = 0;
+		uint64_t key = 0;
+		uint32_t length = 0;
+		uint32_t padding = 0;
+	};
+
+	inline static std::string directory;
+
+	static uint64_t Hash(uint64_t hash, const char* data, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// separator between strings so ("ab", "c") and ("a", "bc") differ
+	static uint64_t Separate(uint64_t hash)
+	{
+		return (hash ^ 0xFF) * 1099511628211ull;
+	}
+
+	static std::string path(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+		return (std::filesystem::path(directory) / name).string();
+	}
+};
+
+#endif // !SHADER_CACHE_H
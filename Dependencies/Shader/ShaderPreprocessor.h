@@ -0,0 +1,191 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <ShaderSource.h>
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Resolves #include "file" directives and injects #define lines into GLSL sources.
+/// The result is a list of pieces pointing into the mapped files, nothing is concatenated.
+/// </summary>
+class ShaderPreprocessor
+{
+public:
+	/// <summary>
+	/// Expands a shader file
+	/// </summary>
+	/// <param name="path">Shader file path, includes are relative to the including file</param>
+	/// <param name="defines">Lines injected after #version, e.g. "USE_TEXTURE" or "LIGHTS 4"</param>
+	/// <param name="source">Destination of the pieces, and of the paths of the files read</param>
+	/// <returns>False if a file can't be read</returns>
+	static bool Expand(const char* path, const std::vector<std::string>& defines, ShaderSource& source)
+	{
+		std::vector<std::string> included;
+		std::string header;
+		for (const std::string& define : defines)
+		{
+			header += "#define " + define + "\n";
+		}
+		bool success = expandFile(path, header.empty() ? NULL : &header, source, included);
+		for (std::string& file : included)
+		{
+			source.addPath(std::move(file));
+		}
+		return success;
+	}
+
+private:
+	static bool expandFile(const std::filesystem::path& path, const std::string* header, ShaderSource& source, std::vector<std::string>& included)
+	{
+		MappedFile file(path.string().c_str());
+		if (!file.isOpen())
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path.string() << std::endl;
+			return false;
+		}
+		std::error_code error;
+		included.push_back(std::filesystem::weakly_canonical(path, error).string());
+		// source string number used by #line, so compile errors point at the right file
+		size_t fileIndex = included.size() - 1;
+
+		const char* data = file.getData();
+		size_t size = file.getSize();
+		source.keep(std::move(file));
+		if (fileIndex > 0)
+		{
+			// an included file starts at its own line 1, the root one may start with #version
+			source.appendCopy(lineDirective(1, fileIndex));
+		}
+
+		// the defines go right after #version, which has to stay the first directive
+		// (comments may come before it), or at the top of a file without one
+		size_t headerAt = header ? findVersion(data, size) : 0;
+
+		bool success = true;
+		size_t pieceStart = 0;
+		size_t lineStart = 0;
+		size_t line = 1;
+		while (lineStart < size)
+		{
+			const char* end = (const char*)memchr(data + lineStart, '\n', size - lineStart);
+			size_t lineEnd = end ? (size_t)(end - data) + 1 : size;
+
+			size_t first = lineStart;
+			while (first < lineEnd && (data[first] == ' ' || data[first] == '\t'))
+			{
+				first++;
+			}
+			const char* text = data + first;
+			size_t length = lineEnd - first;
+
+			if (header && lineStart == headerAt)
+			{
+				source.append(data + pieceStart, headerAt - pieceStart);
+				source.appendCopy(*header + lineDirective(line, fileIndex));
+				pieceStart = headerAt;
+				header = NULL;
+			}
+
+			std::string name;
+			if (startsWith(text, length, "#include") && parseInclude(text + 8, length - 8, name))
+			{
+				source.append(data + pieceStart, lineStart - pieceStart);
+				std::filesystem::path includePath = path.parent_path() / name;
+				std::string canonical = std::filesystem::weakly_canonical(includePath, error).string();
+				// every file is included once, which also stops include cycles
+				bool seen = false;
+				for (const std::string& other : included)
+				{
+					seen = seen || other == canonical;
+				}
+				if (!seen)
+				{
+					success = expandFile(includePath, NULL, source, included) && success;
+				}
+				source.appendCopy(lineDirective(line + 1, fileIndex));
+				pieceStart = lineEnd;
+			}
+
+			lineStart = lineEnd;
+			line++;
+		}
+		source.append(data + pieceStart, size - pieceStart);
+		// an included file may end without a newline, the next #line must start its own line
+		if (size > 0 && data[size - 1] != '\n')
+		{
+			source.appendCopy("\n");
+		}
+		if (header)
+		{
+			// #version was the last line
+			source.appendCopy(*header);
+		}
+		return success;
+	}
+
+	// returns the offset of the line after #version, 0 without #version
+	static size_t findVersion(const char* data, size_t size)
+	{
+		size_t lineStart = 0;
+		while (lineStart < size)
+		{
+			const char* end = (const char*)memchr(data + lineStart, '\n', size - lineStart);
+			size_t lineEnd = end ? (size_t)(end - data) + 1 : size;
+			size_t first = lineStart;
+			while (first < lineEnd && (data[first] == ' ' || data[first] == '\t'))
+			{
+				first++;
+			}
+			if (startsWith(data + first, lineEnd - first, "#version"))
+			{
+				return lineEnd;
+			}
+			lineStart = lineEnd;
+		}
+		return 0;
+	}
+
+	static bool startsWith(const char* text, size_t length, const char* prefix)
+	{
+		size_t prefixLength = strlen(prefix);
+		return length >= prefixLength && memcmp(text, prefix, prefixLength) == 0;
+	}
+
+	// reads the file name of: "name" or <name>
+	static bool parseInclude(const char* text, size_t length, std::string& name)
+	{
+		size_t i = 0;
+		while (i < length && (text[i] == ' ' || text[i] == '\t'))
+		{
+			i++;
+		}
+		if (i == length || (text[i] != '"' && text[i] != '<'))
+		{
+			return false;
+		}
+		char close = text[i] == '"' ? '"' : '>';
+		size_t start = ++i;
+		while (i < length && text[i] != close && text[i] != '\n')
+		{
+			i++;
+		}
+		if (i == length || text[i] != close)
+		{
+			return false;
+		}
+		name.assign(text + start, i - start);
+		return true;
+	}
+
+	static std::string lineDirective(size_t line, size_t fileIndex)
+	{
+		return "#line " + std::to_string(line) + " " + std::to_string(fileIndex) + "\n";
+	}
+};
+
+#endif // !SHADER_PREPROCESSOR_H
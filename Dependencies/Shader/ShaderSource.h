@@ -0,0 +1,138 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <MappedFile.h>
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Source of one shader stage as a list of pieces handed to glShaderSource
+/// as they are (pointer + length), without joining them into one string.
+/// </summary>
+class ShaderSource
+{
+public:
+	ShaderSource() = default;
+
+	// the pieces point into the owned storage: copies would dangle
+	ShaderSource(const ShaderSource&) = delete;
+	ShaderSource& operator=(const ShaderSource&) = delete;
+	ShaderSource(ShaderSource&&) = default;
+	ShaderSource& operator=(ShaderSource&&) = default;
+
+	/// <summary>
+	/// Maps a file and appends its content
+	/// </summary>
+	/// <param name="path">File path</param>
+	/// <returns>False if the file can't be read</returns>
+	bool appendFile(const char* path)
+	{
+		MappedFile file(path);
+		if (!file.isOpen())
+		{
+			return false;
+		}
+		append(file.getData(), file.getSize());
+		files.push_back(std::move(file));
+		return true;
+	}
+
+	/// <summary>
+	/// Keeps a mapped file alive as long as the source, so pieces of it can be appended
+	/// </summary>
+	/// <param name="file">Mapped file</param>
+	void keep(MappedFile file)
+	{
+		files.push_back(std::move(file));
+	}
+
+	/// <summary>
+	/// Appends a piece that is kept alive by the caller (or by keep())
+	/// </summary>
+	/// <param name="data">First character</param>
+	/// <param name="size">Number of characters</param>
+	void append(const char* data, size_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		strings.push_back(data);
+		lengths.push_back((GLint)size);
+	}
+
+	/// <summary>
+	/// Appends a copy of the text
+	/// </summary>
+	/// <param name="text">Text to append</param>
+	void appendCopy(std::string text)
+	{
+		texts.push_back(std::move(text));
+		append(texts.back().data(), texts.back().size());
+	}
+
+	/// <summary>
+	/// Calls glShaderSource with every piece
+	/// </summary>
+	/// <param name="shader">Shader object</param>
+	void upload(GLuint shader) const
+	{
+		glShaderSource(shader, (GLsizei)strings.size(), strings.data(), lengths.data());
+	}
+
+	/// <summary>
+	/// Returns the number of pieces
+	/// </summary>
+	size_t getCount() const
+	{
+		return strings.size();
+	}
+
+	/// <summary>
+	/// Returns a piece
+	/// </summary>
+	const char* getString(size_t i) const
+	{
+		return strings[i];
+	}
+
+	/// <summary>
+	/// Returns the length of a piece
+	/// </summary>
+	size_t getLength(size_t i) const
+	{
+		return (size_t)lengths[i];
+	}
+
+	/// <summary>
+	/// Records a file the pieces were read from
+	/// </summary>
+	/// <param name="path">File path</param>
+	void addPath(std::string path)
+	{
+		paths.push_back(std::move(path));
+	}
+
+	/// <summary>
+	/// Returns the files the pieces were read from, includes too, in the order they were read
+	/// </summary>
+	const std::vector<std::string>& getPaths() const
+	{
+		return paths;
+	}
+
+private:
+	std::vector<const char*> strings;
+	std::vector<GLint> lengths;
+	// storage of the pieces: mapped files and copied text (a deque never moves its elements)
+	std::vector<MappedFile> files;
+	std::deque<std::string> texts;
+	std::vector<std::string> paths;
+};
+
+#endif // !SHADER_SOURCE_H
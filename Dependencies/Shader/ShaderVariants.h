@@ -0,0 +1,96 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <Shader.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Permutations of one shader compiled on demand.
+/// Bit i of a variant key defines features[i], so features are chosen at compile time
+/// instead of branching on uniforms, and only the keys actually requested get compiled.
+/// </summary>
+class ShaderVariants
+{
+public:
+	/// <summary>
+	/// Describes the permutations, nothing is compiled yet
+	/// </summary>
+	/// <param name="vertexPath">Vertex shader file path</param>
+	/// <param name="fragmentPath">Fragment shader file path</param>
+	/// <param name="features">Define of each key bit, at most 32</param>
+	ShaderVariants(const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& features)
+		: vertexPath(vertexPath), fragmentPath(fragmentPath), features(features)
+	{
+	}
+
+	/// <summary>
+	/// Returns the key with the bit of a feature set
+	/// </summary>
+	/// <param name="feature">Define name as given to the constructor</param>
+	uint32_t getBit(const std::string& feature) const
+	{
+		for (size_t i = 0; i < features.size(); i++)
+		{
+			if (features[i] == feature)
+			{
+				return 1u << i;
+			}
+		}
+		return 0;
+	}
+
+	/// <summary>
+	/// Starts compiling a permutation ahead of its first use
+	/// </summary>
+	/// <param name="key">Variant key</param>
+	void prepare(uint32_t key)
+	{
+		if (variants.find(key) == variants.end())
+		{
+			variants.emplace(key, Shader(vertexPath.c_str(), fragmentPath.c_str(), getDefines(key), ShaderCompile::Deferred));
+		}
+	}
+
+	/// <summary>
+	/// Returns a permutation, compiling it the first time it's requested
+	/// </summary>
+	/// <param name="key">Variant key</param>
+	const Shader& get(uint32_t key)
+	{
+		prepare(key);
+		return variants.find(key)->second;
+	}
+
+	/// <summary>
+	/// Returns the number of permutations compiled so far
+	/// </summary>
+	size_t getCount() const
+	{
+		return variants.size();
+	}
+
+private:
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::vector<std::string> features;
+	std::unordered_map<uint32_t, Shader> variants;
+
+	std::vector<std::string> getDefines(uint32_t key) const
+	{
+		std::vector<std::string> defines;
+		for (size_t i = 0; i < features.size() && i < 32; i++)
+		{
+			if (key & (1u << i))
+			{
+				defines.push_back(features[i]);
+			}
+		}
+		return defines;
+	}
+};
+
+#endif // !SHADER_VARIANTS_H
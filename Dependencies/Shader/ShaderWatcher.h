@@ -0,0 +1,223 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <Shader.h>
+#include <ShaderPreprocessor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/// <summary>
+/// Reloads a Shader when its files change on disk, the stage files and the files they include.
+/// A background thread watches the files (inotify on Linux, modification time elsewhere),
+/// the new program is compiled deferred so the driver builds it while frames keep
+/// being drawn, and it replaces the live one between frames only if it links.
+/// </summary>
+class ShaderWatcher
+{
+public:
+	/// <summary>
+	/// Starts watching the shader files
+	/// </summary>
+	/// <param name="shader">Shader that receives the reloaded program</param>
+	/// <param name="vertexPath">Vertex shader file path</param>
+	/// <param name="fragmentPath">Fragment shader file path</param>
+	/// <param name="defines">Defines the shader was built with, the reloads get them too</param>
+	ShaderWatcher(Shader& shader, const std::string& vertexPath, const std::string& fragmentPath, const std::vector<std::string>& defines = std::vector<std::string>())
+		: shader(shader), paths{ vertexPath, fragmentPath }, defines(defines), files(collectFiles())
+	{
+		thread = std::thread(&ShaderWatcher::watch, this);
+	}
+
+	~ShaderWatcher()
+	{
+		running = false;
+		thread.join();
+	}
+
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	/// <summary>
+	/// Call once per frame, outside of the draw calls.
+	/// Returns true when the program was swapped: uniform handles must be fetched again
+	/// </summary>
+	bool update()
+	{
+		if (!candidate && changed.exchange(false))
+		{
+			candidate.reset(new Shader(paths[0].c_str(), paths[1].c_str(), defines, ShaderCompile::Deferred));
+			// the edit may have added or removed an #include
+			std::vector<std::string> current = collectFiles();
+			std::lock_guard<std::mutex> lock(mutex);
+			if (current != files)
+			{
+				files = std::move(current);
+				filesChanged = true;
+			}
+		}
+		if (!candidate || !candidate->isReady())
+		{
+			return false;
+		}
+
+		std::unique_ptr<Shader> reloaded = std::move(candidate);
+		if (!reloaded->isLinked())
+		{
+			// the errors were printed by the Shader, keep drawing with the previous program
+			std::cout << "LOG::SHADER_WATCHER::RELOAD_FAILED keeping the previous program" << std::endl;
+			return false;
+		}
+		shader = std::move(*reloaded);
+		std::cout << "LOG::SHADER_WATCHER::RELOADED " << paths[0] << " " << paths[1] << std::endl;
+		return true;
+	}
+
+private:
+	Shader& shader;
+	std::string paths[2];
+	std::vector<std::string> defines;
+	std::unique_ptr<Shader> candidate;
+
+	// watched files, read by the thread when filesChanged is set
+	std::mutex mutex;
+	std::vector<std::string> files;
+	std::atomic<bool> filesChanged{ false };
+
+	std::thread thread;
+	std::atomic<bool> running{ true };
+	std::atomic<bool> changed{ false };
+
+	// the stage files and everything they include, a stage that can't be read is watched anyway
+	std::vector<std::string> collectFiles() const
+	{
+		std::vector<std::string> collected;
+		for (const std::string& path : paths)
+		{
+			std::error_code error;
+			collected.push_back(std::filesystem::weakly_canonical(path, error).string());
+			ShaderSource source;
+			ShaderPreprocessor::Expand(path.c_str(), defines, source);
+			collected.insert(collected.end(), source.getPaths().begin(), source.getPaths().end());
+		}
+		std::sort(collected.begin(), collected.end());
+		collected.erase(std::unique(collected.begin(), collected.end()), collected.end());
+		return collected;
+	}
+
+	std::vector<std::string> getFiles()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		filesChanged = false;
+		return files;
+	}
+
+#ifdef __linux__
+	void watch()
+	{
+		int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0)
+		{
+			std::cout << "ERROR::SHADER_WATCHER::INOTIFY_FAILED" << std::endl;
+			return;
+		}
+
+		// watch the directories: editors often save by replacing the file
+		std::vector<int> watches;
+		std::vector<std::string> names;
+		alignas(inotify_event) char buffer[4096];
+		pollfd descriptor = { fd, POLLIN, 0 };
+		filesChanged = true;
+		while (running)
+		{
+			if (filesChanged)
+			{
+				for (int watch : watches)
+				{
+					inotify_rm_watch(fd, watch);
+				}
+				watches.clear();
+				names.clear();
+				for (const std::string& file : getFiles())
+				{
+					std::filesystem::path path(file);
+					std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+					// a directory watched twice gets the same descriptor
+					watches.push_back(inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE));
+					names.push_back(path.filename().string());
+				}
+			}
+
+			// wake up regularly to check if the watcher is being destroyed
+			if (poll(&descriptor, 1, 100) <= 0)
+			{
+				continue;
+			}
+			ssize_t length;
+			while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+				{
+					const inotify_event* event = (const inotify_event*)p;
+					for (size_t i = 0; i < watches.size(); i++)
+					{
+						if (event->len && event->wd == watches[i] && names[i] == event->name)
+						{
+							changed = true;
+						}
+					}
+				}
+			}
+		}
+		close(fd);
+	}
+#else
+	void watch()
+	{
+		std::vector<std::string> watched;
+		std::vector<std::filesystem::file_time_type> times;
+		filesChanged = true;
+		while (running)
+		{
+			if (filesChanged)
+			{
+				watched = getFiles();
+				times.assign(watched.size(), std::filesystem::file_time_type());
+				for (size_t i = 0; i < watched.size(); i++)
+				{
+					std::error_code error;
+					times[i] = std::filesystem::last_write_time(watched[i], error);
+				}
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			for (size_t i = 0; i < watched.size(); i++)
+			{
+				std::error_code error;
+				std::filesystem::file_time_type time = std::filesystem::last_write_time(watched[i], error);
+				if (!error && time != times[i])
+				{
+					times[i] = time;
+					changed = true;
+				}
+			}
+		}
+	}
+#endif
+};
+
+#endif // !SHADER_WATCHER_H
@@ -0,0 +1,217 @@
+#ifndef BINDLESS_TEXTURES_H
+#define BINDLESS_TEXTURES_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <GLExt.h>
+#include <TextureFormat.h>
+#include <TextureLoader.h>
+
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <vector>
+
+/// <summary>
+/// Bindless textures (ARB_bindless_texture): the 64 bit handles of the textures live in a
+/// uniform buffer the shaders index, so draws with different textures need no glBindTexture.
+/// Only resident handles may be sampled: a texture is made resident when it's used, and the
+/// least recently used ones are made non-resident once more than a budget of them are,
+/// so the driver is free to page them out of video memory.
+/// Check IsSupported() first: without the extension the samples pack the images in a TextureAtlas.
+/// </summary>
+class BindlessTextures
+{
+public:
+	// 16 KB of handles, the smallest GL_MAX_UNIFORM_BLOCK_SIZE allowed: declared in GLSL as
+	// layout(std140) uniform BindlessTextures { uvec4 handles[1024]; }, two handles per element
+	static const size_t MAX_TEXTURES = 2048;
+
+	/// <summary>
+	/// Returns true if the context has ARB_bindless_texture
+	/// </summary>
+	static bool IsSupported()
+	{
+		return GLExt::GetTextureHandle != NULL;
+	}
+
+	/// <summary>
+	/// Creates the handle buffer, needs a context with ARB_bindless_texture
+	/// </summary>
+	/// <param name="residentBudget">Textures kept resident at most, unless a single frame uses more</param>
+	explicit BindlessTextures(size_t residentBudget = 256)
+		: residentBudget(residentBudget)
+	{
+		std::vector<GLuint64> zeros(MAX_TEXTURES, 0);
+		glGenBuffers(1, &ubo);
+		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+		glBufferData(GL_UNIFORM_BUFFER, MAX_TEXTURES * sizeof(GLuint64), zeros.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	/// <summary>
+	/// Makes every handle non-resident and deletes the textures and the handle buffer
+	/// </summary>
+	~BindlessTextures()
+	{
+		for (const Entry& entry : entries)
+		{
+			if (entry.resident)
+			{
+				GLExt::MakeTextureHandleNonResident(entry.handle);
+			}
+			glDeleteTextures(1, &entry.texture);
+		}
+		glDeleteBuffers(1, &ubo);
+	}
+
+	BindlessTextures(const BindlessTextures&) = delete;
+	BindlessTextures& operator=(const BindlessTextures&) = delete;
+
+	/// <summary>
+	/// Takes ownership of a complete texture and publishes its handle.
+	/// Its sampling parameters are frozen from now on, set them before
+	/// </summary>
+	/// <param name="texture">Texture object</param>
+	/// <returns>Index of the handle in the buffer, MAX_TEXTURES if the buffer is full</returns>
+	size_t add(GLuint texture)
+	{
+		if (entries.size() == MAX_TEXTURES)
+		{
+			std::cout << "ERROR::BINDLESS_TEXTURES::FULL " << MAX_TEXTURES << " textures" << std::endl;
+			glDeleteTextures(1, &texture);
+			return MAX_TEXTURES;
+		}
+		Entry entry;
+		entry.texture = texture;
+		entry.handle = GLExt::GetTextureHandle(texture);
+		entries.push_back(entry);
+		// the handle never changes, only its residency does: written once
+		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+		glBufferSubData(GL_UNIFORM_BUFFER, (entries.size() - 1) * sizeof(GLuint64), sizeof(GLuint64), &entry.handle);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		return entries.size() - 1;
+	}
+
+	/// <summary>
+	/// Uploads pixels to a new mipmapped texture and publishes its handle
+	/// </summary>
+	/// <param name="pixels">Rows tightly packed</param>
+	/// <param name="width">Width of the image</param>
+	/// <param name="height">Height of the image</param>
+	/// <param name="channels">1 to 4</param>
+	/// <param name="srgb">The image holds sRGB colors</param>
+	/// <returns>Index of the handle in the buffer, MAX_TEXTURES if the buffer is full</returns>
+	size_t add(const unsigned char* pixels, int width, int height, int channels, bool srgb = false)
+	{
+		TextureFormat format = TextureFormat::Choose(channels, 8, srgb);
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		TextureFormat::Allocate(format.internalFormat, TextureFormat::LevelCount(width, height), width, height);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, TextureFormat::UnpackAlignment((size_t)width * format.bytesPerPixel));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format.format, format.type, pixels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return add(texture);
+	}
+
+	/// <summary>
+	/// Uploads a decoded image to a new mipmapped texture and publishes its handle
+	/// </summary>
+	/// <returns>Index of the handle in the buffer, MAX_TEXTURES if the buffer is full</returns>
+	size_t add(const Image& image, bool srgb = false)
+	{
+		return add(image.getPixels(), image.getWidth(), image.getHeight(), image.getChannels(), srgb);
+	}
+
+	/// <summary>
+	/// Marks a texture as used by the current frame, making it resident if it isn't.
+	/// Call it for every texture a draw samples, before the draw
+	/// </summary>
+	/// <param name="index">Value returned by add()</param>
+	void use(size_t index)
+	{
+		Entry& entry = entries[index];
+		if (entry.lastUse == frame && entry.resident)
+		{
+			return;
+		}
+		if (entry.resident)
+		{
+			lru.erase(entry.position);
+		}
+		else
+		{
+			GLExt::MakeTextureHandleResident(entry.handle);
+			entry.resident = true;
+			residentCount++;
+		}
+		lru.push_front(index);
+		entry.position = lru.begin();
+		entry.lastUse = frame;
+	}
+
+	/// <summary>
+	/// Call once per frame, after its draws: makes the least recently used textures
+	/// non-resident until the budget is met, never the ones of the frame just drawn
+	/// </summary>
+	void update()
+	{
+		while (residentCount > residentBudget && !lru.empty() && entries[lru.back()].lastUse != frame)
+		{
+			Entry& entry = entries[lru.back()];
+			GLExt::MakeTextureHandleNonResident(entry.handle);
+			entry.resident = false;
+			residentCount--;
+			lru.pop_back();
+		}
+		frame++;
+	}
+
+	/// <summary>
+	/// Binds the handle buffer to a uniform block binding point
+	/// </summary>
+	/// <param name="binding">Binding point of the BindlessTextures block</param>
+	void bind(GLuint binding) const
+	{
+		glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+	}
+
+	size_t getCount() const
+	{
+		return entries.size();
+	}
+
+	size_t getResidentCount() const
+	{
+		return residentCount;
+	}
+
+private:
+	struct Entry
+	{
+		GLuint texture = 0;
+		GLuint64 handle = 0;
+		bool resident = false;
+		uint64_t lastUse = 0;
+		// in the lru list while resident
+		std::list<size_t>::iterator position;
+	};
+
+	size_t residentBudget;
+	GLuint ubo = 0;
+	std::vector<Entry> entries;
+	// resident textures, most recently used first
+	std::list<size_t> lru;
+	size_t residentCount = 0;
+	// starts at 1 so no texture looks used by the current frame before its first use()
+	uint64_t frame = 1;
+};
+
+#endif // !BINDLESS_TEXTURES_H
@@ -0,0 +1,536 @@
+#ifndef BLOCK_COMPRESSOR_H
+#define BLOCK_COMPRESSOR_H
+
+#include <CpuProfiler.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+/// <summary>
+/// Layout of the texels of a cooked texture level
+/// </summary>
+enum class BlockFormat
+{
+	// rows of 8 bit texels
+	Uncompressed,
+	// S3TC DXT1: 4x4 RGB texels in 8 bytes
+	BC1,
+	// S3TC DXT5: 4x4 RGBA texels in 16 bytes, BC1 color with interpolated alpha
+	BC3
+};
+
+/// <summary>
+/// CPU encoder and decoder of S3TC blocks.
+/// BC1 endpoints follow the principal axis of the block colors and are refined by least squares,
+/// the texels pick the closest palette entry (SSE2 when available). Rows of blocks are encoded on the pool.
+/// </summary>
+class BlockCompressor
+{
+public:
+	/// <summary>
+	/// Returns the bytes of a 4x4 block
+	/// </summary>
+	static int BlockBytes(BlockFormat format)
+	{
+		return format == BlockFormat::BC1 ? 8 : 16;
+	}
+
+	/// <summary>
+	/// Returns the bytes of a level of the given size
+	/// </summary>
+	static size_t EncodedSize(int width, int height, BlockFormat format)
+	{
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+	}
+
+	/// <summary>
+	/// Encodes an 8 bit image, partial blocks at the right/bottom edges repeat the last texels
+	/// </summary>
+	/// <param name="pixels">Rows of the image, tightly packed</param>
+	/// <param name="width">Width in pixels</param>
+	/// <param name="height">Height in pixels</param>
+	/// <param name="channels">Bytes per pixel, 3 or 4 (BC1 ignores alpha)</param>
+	/// <param name="format">BC1 or BC3</param>
+	/// <param name="pool">Workers encoding rows of blocks, NULL runs on the calling thread</param>
+	/// <param name="simd">Use the SSE2 palette search, false runs the scalar reference</param>
+	/// <returns>Blocks, row by row</returns>
+	static std::vector<unsigned char> Encode(const unsigned char* pixels, int width, int height, int channels, BlockFormat format, ThreadPool* pool = NULL, bool simd = true)
+	{
+		PROFILE_SCOPE("block compress");
+		std::vector<unsigned char> blocks(EncodedSize(width, height, format));
+		Pass pass = { pixels, width, height, channels, format, simd, blocks.data() };
+
+		int blockRows = (height + 3) / 4;
+		int parts = 1;
+		if (pool && (size_t)width * height >= 256 * 256)
+		{
+			parts = (int)std::min<size_t>(blockRows, pool->getCount() * 4);
+		}
+		int rows = (blockRows + parts - 1) / parts;
+		std::vector<std::future<void>> jobs;
+		for (int y = rows; y < blockRows; y += rows)
+		{
+			int end = std::min(blockRows, y + rows);
+			jobs.push_back(pool->submit([&pass, y, end]() { EncodeRows(pass, y, end); }));
+		}
+		EncodeRows(pass, 0, std::min(blockRows, rows));
+		for (std::future<void>& job : jobs)
+		{
+			job.get();
+		}
+		return blocks;
+	}
+
+	/// <summary>
+	/// Decodes blocks to RGBA 8 bit rows, for drivers without S3TC
+	/// </summary>
+	/// <param name="blocks">Blocks, row by row</param>
+	/// <param name="width">Width in pixels</param>
+	/// <param name="height">Height in pixels</param>
+	/// <param name="format">BC1 or BC3</param>
+	static std::vector<unsigned char> Decode(const unsigned char* blocks, int width, int height, BlockFormat format)
+	{
+		std::vector<unsigned char> pixels((size_t)width * height * 4);
+		int blocksX = (width + 3) / 4;
+		int blockBytes = BlockBytes(format);
+		unsigned char texels[64];
+		for (int by = 0; by < (height + 3) / 4; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				const unsigned char* block = blocks + ((size_t)by * blocksX + bx) * blockBytes;
+				if (format == BlockFormat::BC3)
+				{
+					DecodeColor(block + 8, texels, true);
+					DecodeAlpha(block, texels);
+				}
+				else
+				{
+					DecodeColor(block, texels, false);
+				}
+				for (int y = 0; y < 4 && by * 4 + y < height; y++)
+				{
+					for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+					{
+						memcpy(&pixels[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], texels + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+		return pixels;
+	}
+
+private:
+	struct Pass
+	{
+		const unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		BlockFormat format;
+		bool simd;
+		unsigned char* blocks;
+	};
+
+	static void EncodeRows(const Pass& pass, int begin, int end)
+	{
+		int blocksX = (pass.width + 3) / 4;
+		int blockBytes = BlockBytes(pass.format);
+		unsigned char texels[64];
+		for (int by = begin; by < end; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				// gather the block as RGBA, clamping to the image edges
+				for (int y = 0; y < 4; y++)
+				{
+					int row = std::min(pass.height - 1, by * 4 + y);
+					for (int x = 0; x < 4; x++)
+					{
+						int column = std::min(pass.width - 1, bx * 4 + x);
+						const unsigned char* texel = pass.pixels + ((size_t)row * pass.width + column) * pass.channels;
+						unsigned char* out = texels + (y * 4 + x) * 4;
+						out[0] = texel[0];
+						out[1] = texel[1];
+						out[2] = texel[2];
+						out[3] = pass.channels == 4 ? texel[3] : 255;
+					}
+				}
+				unsigned char* block = pass.blocks + ((size_t)by * blocksX + bx) * blockBytes;
+				if (pass.format == BlockFormat::BC3)
+				{
+					EncodeAlpha(texels, block);
+					EncodeColor(texels, block + 8, pass.simd);
+				}
+				else
+				{
+					EncodeColor(texels, block, pass.simd);
+				}
+			}
+		}
+	}
+
+	static uint16_t Pack565(const float color[3])
+	{
+		int r = std::min(31, std::max(0, (int)(color[0] * (31.0f / 255.0f) + 0.5f)));
+		int g = std::min(63, std::max(0, (int)(color[1] * (63.0f / 255.0f) + 0.5f)));
+		int b = std::min(31, std::max(0, (int)(color[2] * (31.0f / 255.0f) + 0.5f)));
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	static void Unpack565(uint16_t color, int out[3])
+	{
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	// the 4 colors of a block in 4 color mode
+	static void Palette(uint16_t color0, uint16_t color1, int palette[4][3])
+	{
+		Unpack565(color0, palette[0]);
+		Unpack565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	}
+
+	// picks the closest palette entry of each texel, returns the squared error
+	static int SelectIndices(const unsigned char* texels, const int palette[4][3], uint32_t& indices, bool simd)
+	{
+#ifdef BLOCK_COMPRESSOR_SSE2
+		if (simd)
+		{
+			return SelectIndicesSSE2(texels, palette, indices);
+		}
+#endif
+		indices = 0;
+		int error = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			const unsigned char* texel = texels + i * 4;
+			int best = 0;
+			int bestDistance = 1 << 30;
+			for (int p = 0; p < 4; p++)
+			{
+				int dr = texel[0] - palette[p][0];
+				int dg = texel[1] - palette[p][1];
+				int db = texel[2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (uint32_t)best << (i * 2);
+			error += bestDistance;
+		}
+		return error;
+	}
+
+#ifdef BLOCK_COMPRESSOR_SSE2
+	static int SelectIndicesSSE2(const unsigned char* texels, const int palette[4][3], uint32_t& indices)
+	{
+		// texel and palette channels widened to 16 bit, alpha zeroed so it doesn't count
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		__m128i entries[4];
+		for (int p = 0; p < 4; p++)
+		{
+			entries[p] = _mm_setr_epi16((short)palette[p][0], (short)palette[p][1], (short)palette[p][2], 0,
+				(short)palette[p][0], (short)palette[p][1], (short)palette[p][2], 0);
+		}
+
+		indices = 0;
+		__m128i errors = zero;
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128i four = _mm_and_si128(_mm_loadu_si128((const __m128i*)(texels + i * 4)), colorMask);
+			__m128i low = _mm_unpacklo_epi8(four, zero);
+			__m128i high = _mm_unpackhi_epi8(four, zero);
+
+			__m128i bestDistance = _mm_set1_epi32(1 << 30);
+			__m128i best = zero;
+			for (int p = 0; p < 4; p++)
+			{
+				__m128i dl = _mm_sub_epi16(low, entries[p]);
+				__m128i dh = _mm_sub_epi16(high, entries[p]);
+				// (r*r + g*g, b*b) pairs per texel, then one sum per texel: [t0, t1, t2, t3]
+				__m128i sl = _mm_madd_epi16(dl, dl);
+				__m128i sh = _mm_madd_epi16(dh, dh);
+				__m128i sums = _mm_add_epi32(
+					_mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(sl), _mm_castsi128_ps(sh), _MM_SHUFFLE(2, 0, 2, 0))),
+					_mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(sl), _mm_castsi128_ps(sh), _MM_SHUFFLE(3, 1, 3, 1))));
+				// strictly smaller keeps the lowest entry on ties, like the scalar search
+				__m128i closer = _mm_cmplt_epi32(sums, bestDistance);
+				bestDistance = _mm_or_si128(_mm_and_si128(closer, sums), _mm_andnot_si128(closer, bestDistance));
+				best = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, best));
+			}
+			errors = _mm_add_epi32(errors, bestDistance);
+
+			int selected[4];
+			_mm_storeu_si128((__m128i*)selected, best);
+			for (int t = 0; t < 4; t++)
+			{
+				indices |= (uint32_t)selected[t] << ((i + t) * 2);
+			}
+		}
+		int sums[4];
+		_mm_storeu_si128((__m128i*)sums, errors);
+		return sums[0] + sums[1] + sums[2] + sums[3];
+	}
+#endif
+
+	static void EncodeColor(const unsigned char* texels, unsigned char* block, bool simd)
+	{
+		// principal axis of the colors: power iteration on the covariance matrix
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				mean[c] += texels[i * 4 + c];
+			}
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			mean[c] /= 16.0f;
+		}
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			float r = texels[i * 4 + 0] - mean[0];
+			float g = texels[i * 4 + 1] - mean[1];
+			float b = texels[i * 4 + 2] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		// endpoints: the extreme projections on the axis
+		float lowest = 1e30f;
+		float highest = -1e30f;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = (texels[i * 4 + 0] - mean[0]) * axis[0] + (texels[i * 4 + 1] - mean[1]) * axis[1] + (texels[i * 4 + 2] - mean[2]) * axis[2];
+			lowest = std::min(lowest, t);
+			highest = std::max(highest, t);
+		}
+		float norm = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		float end0[3];
+		float end1[3];
+		for (int c = 0; c < 3; c++)
+		{
+			end0[c] = norm > 0.0f ? mean[c] + axis[c] * highest / norm : mean[c];
+			end1[c] = norm > 0.0f ? mean[c] + axis[c] * lowest / norm : mean[c];
+		}
+
+		uint16_t color0 = Pack565(end0);
+		uint16_t color1 = Pack565(end1);
+		int palette[4][3];
+		Palette(color0, color1, palette);
+		uint32_t indices;
+		int error = SelectIndices(texels, palette, indices, simd);
+
+		// least squares endpoints for the chosen indices, kept when they lower the error
+		static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		for (int iteration = 0; iteration < 2 && error > 0; iteration++)
+		{
+			float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+			float ax[3] = { 0.0f, 0.0f, 0.0f };
+			float bx[3] = { 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				float a = weights[(indices >> (i * 2)) & 3];
+				float b = 1.0f - a;
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (int c = 0; c < 3; c++)
+				{
+					ax[c] += a * texels[i * 4 + c];
+					bx[c] += b * texels[i * 4 + c];
+				}
+			}
+			float determinant = aa * bb - ab * ab;
+			if (std::fabs(determinant) < 1e-6f)
+			{
+				break;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				end0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+				end1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+			}
+			uint16_t refined0 = Pack565(end0);
+			uint16_t refined1 = Pack565(end1);
+			int refinedPalette[4][3];
+			Palette(refined0, refined1, refinedPalette);
+			uint32_t refinedIndices;
+			int refinedError = SelectIndices(texels, refinedPalette, refinedIndices, simd);
+			if (refinedError >= error)
+			{
+				break;
+			}
+			color0 = refined0;
+			color1 = refined1;
+			indices = refinedIndices;
+			error = refinedError;
+		}
+
+		// color0 > color1 selects the 4 color mode, swapping the endpoints swaps the indices 0<->1 and 2<->3
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+			indices ^= 0x55555555;
+		}
+		else if (color0 == color1)
+		{
+			indices = 0;
+		}
+		block[0] = (unsigned char)(color0 & 0xFF);
+		block[1] = (unsigned char)(color0 >> 8);
+		block[2] = (unsigned char)(color1 & 0xFF);
+		block[3] = (unsigned char)(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			block[4 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	static void EncodeAlpha(const unsigned char* texels, unsigned char* block)
+	{
+		int highest = 0;
+		int lowest = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			highest = std::max(highest, (int)texels[i * 4 + 3]);
+			lowest = std::min(lowest, (int)texels[i * 4 + 3]);
+		}
+		// alpha0 > alpha1 selects 6 interpolated values between the endpoints
+		block[0] = (unsigned char)highest;
+		block[1] = (unsigned char)lowest;
+		uint64_t indices = 0;
+		if (highest > lowest)
+		{
+			int range = highest - lowest;
+			for (int i = 0; i < 16; i++)
+			{
+				// step of the alpha between lowest (0) and highest (7), mapped to the index order 0, 7..2, 1
+				int step = ((texels[i * 4 + 3] - lowest) * 7 + range / 2) / range;
+				uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+				indices |= index << (i * 3);
+			}
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			block[2 + i] = (unsigned char)(indices >> (i * 8));
+		}
+	}
+
+	static void DecodeColor(const unsigned char* block, unsigned char* texels, bool alwaysFourColors)
+	{
+		uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+		uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+		int palette[4][4];
+		Unpack565(color0, palette[0]);
+		Unpack565(color1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+		bool fourColors = alwaysFourColors || color0 > color1;
+		for (int c = 0; c < 3; c++)
+		{
+			if (fourColors)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		if (!fourColors)
+		{
+			// 3 color mode: index 3 is transparent black
+			palette[3][3] = 0;
+		}
+		uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+		for (int i = 0; i < 16; i++)
+		{
+			const int* color = palette[(indices >> (i * 2)) & 3];
+			for (int c = 0; c < 4; c++)
+			{
+				texels[i * 4 + c] = (unsigned char)color[c];
+			}
+		}
+	}
+
+	static void DecodeAlpha(const unsigned char* block, unsigned char* texels)
+	{
+		int alpha[8];
+		alpha[0] = block[0];
+		alpha[1] = block[1];
+		if (alpha[0] > alpha[1])
+		{
+			for (int i = 1; i < 7; i++)
+			{
+				alpha[i + 1] = ((7 - i) * alpha[0] + i * alpha[1]) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+			{
+				alpha[i + 1] = ((5 - i) * alpha[0] + i * alpha[1]) / 5;
+			}
+			alpha[6] = 0;
+			alpha[7] = 255;
+		}
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			indices |= (uint64_t)block[2 + i] << (i * 8);
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			texels[i * 4 + 3] = (unsigned char)alpha[(indices >> (i * 3)) & 7];
+		}
+	}
+};
+
+#endif // !BLOCK_COMPRESSOR_H
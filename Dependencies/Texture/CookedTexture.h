@@ -0,0 +1,225 @@
+#ifndef COOKED_TEXTURE_H
+#define COOKED_TEXTURE_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <BlockCompressor.h>
+#include <CpuProfiler.h>
+#include <GLExt.h>
+#include <MappedFile.h>
+#include <MipGenerator.h>
+#include <TextureFormat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Texture container written by the TextureCooker tool (.ctex), loosely modeled on KTX2:
+/// a header, a table with one entry per mip level, then the levels ready to be uploaded.
+/// Rows are padded to 4 bytes (the default GL_UNPACK_ALIGNMENT) and levels start 16 byte aligned,
+/// so the mapped file is handed to glTexSubImage2D as it is: no decoding, no mipmap generation.
+/// Levels can also be BC1/BC3 blocks (a row is then a row of blocks), uploaded with
+/// glCompressedTexSubImage2D or decoded on the CPU when the driver lacks S3TC.
+/// </summary>
+class CookedTexture
+{
+public:
+	static const uint32_t VERSION = 1;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t channels;
+		uint32_t levelCount;
+		// BlockFormat, 0 (uncompressed) in the files written before compression existed
+		uint32_t format;
+	};
+
+	struct Level
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t width;
+		uint32_t height;
+		uint32_t rowStride;
+		uint32_t padding;
+	};
+
+	/// <summary>
+	/// Writes a mip chain, through a temporary file so a running sample never maps a partial one
+	/// </summary>
+	/// <param name="path">Output file path</param>
+	/// <param name="levels">Mip chain, rows tightly packed, or blocks encoded by BlockCompressor</param>
+	/// <param name="channels">Bytes per pixel of the source image</param>
+	/// <param name="format">Layout of the levels</param>
+	/// <returns>False if the file can't be written</returns>
+	static bool Write(const std::string& path, const std::vector<MipLevel>& levels, int channels, BlockFormat format = BlockFormat::Uncompressed)
+	{
+		Header header = {};
+		memcpy(header.magic, Magic(), sizeof(header.magic));
+		header.version = VERSION;
+		header.width = levels[0].width;
+		header.height = levels[0].height;
+		header.channels = channels;
+		header.levelCount = (uint32_t)levels.size();
+		header.format = (uint32_t)format;
+
+		std::vector<Level> table(levels.size());
+		uint64_t offset = Align(sizeof(Header) + sizeof(Level) * table.size(), 16);
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			table[i] = {};
+			table[i].width = levels[i].width;
+			table[i].height = levels[i].height;
+			table[i].rowStride = (uint32_t)Align(RowSize(levels[i].width, channels, format), 4);
+			table[i].size = (uint64_t)table[i].rowStride * RowCount(levels[i].height, format);
+			table[i].offset = offset;
+			offset = Align(offset + table[i].size, 16);
+		}
+
+		std::string temporary = path + ".tmp";
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)table.data(), sizeof(Level) * table.size());
+		static const char zeros[16] = {};
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			file.write(zeros, table[i].offset - (uint64_t)file.tellp());
+			size_t rowSize = (size_t)RowSize(levels[i].width, channels, format);
+			for (int y = 0; y < RowCount(levels[i].height, format); y++)
+			{
+				file.write((const char*)levels[i].pixels.data() + y * rowSize, rowSize);
+				file.write(zeros, table[i].rowStride - rowSize);
+			}
+		}
+		file.close();
+		if (!file)
+		{
+			std::remove(temporary.c_str());
+			return false;
+		}
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		return !error;
+	}
+
+	/// <summary>
+	/// Maps a cooked texture and uploads every level to a new GL_TEXTURE_2D with immutable storage, left bound
+	/// </summary>
+	/// <param name="path">.ctex file path</param>
+	/// <param name="srgb">The texture holds sRGB colors, stored in an sRGB format so sampling returns linear values</param>
+	/// <returns>Texture object, 0 if the file is missing or invalid</returns>
+	static GLuint Upload(const std::string& path, bool srgb = false)
+	{
+		PROFILE_SCOPE("cooked texture upload");
+		MappedFile file(path.c_str());
+		if (!file.isOpen())
+		{
+			return 0;
+		}
+		const char* data = file.getData();
+		size_t size = file.getSize();
+		const Header* header = (const Header*)data;
+		if (size < sizeof(Header) || memcmp(header->magic, Magic(), sizeof(header->magic)) != 0 || header->version != VERSION
+			|| header->channels < 1 || header->channels > 4 || header->levelCount == 0 || header->format > (uint32_t)BlockFormat::BC3
+			|| header->width == 0 || header->height == 0 || header->levelCount > (uint32_t)TextureFormat::LevelCount(header->width, header->height)
+			|| size < sizeof(Header) + sizeof(Level) * (uint64_t)header->levelCount)
+		{
+			std::cout << "ERROR::COOKED_TEXTURE::INVALID_FILE " << path << std::endl;
+			return 0;
+		}
+		const Level* levels = (const Level*)(data + sizeof(Header));
+		BlockFormat format = (BlockFormat)header->format;
+		for (uint32_t i = 0; i < header->levelCount; i++)
+		{
+			if (levels[i].width != std::max(header->width >> i, 1u) || levels[i].height != std::max(header->height >> i, 1u)
+				|| levels[i].offset > size || levels[i].size > size - levels[i].offset
+				|| levels[i].rowStride != Align(RowSize(levels[i].width, header->channels, format), 4)
+				|| levels[i].size < (uint64_t)levels[i].rowStride * RowCount(levels[i].height, format))
+			{
+				std::cout << "ERROR::COOKED_TEXTURE::INVALID_FILE " << path << std::endl;
+				return 0;
+			}
+		}
+
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		// a chain that doesn't reach 1x1 is still complete: the storage ends at the last cooked level
+		GLsizei levelCount = (GLsizei)header->levelCount;
+		if (format == BlockFormat::Uncompressed)
+		{
+			// rows are cooked 4 byte aligned, the default GL_UNPACK_ALIGNMENT
+			TextureFormat pixelFormat = TextureFormat::Choose(header->channels, 8, srgb);
+			TextureFormat::Allocate(pixelFormat.internalFormat, levelCount, levels[0].width, levels[0].height);
+			for (uint32_t i = 0; i < header->levelCount; i++)
+			{
+				glTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, levels[i].width, levels[i].height, pixelFormat.format, pixelFormat.type, data + levels[i].offset);
+			}
+		}
+		else if (GLExt::HasExtension("GL_EXT_texture_compression_s3tc"))
+		{
+			// the blocks go to the GPU as they are, it samples them compressed
+			bool srgbBlocks = srgb && (GLExt::HasExtension("GL_EXT_texture_sRGB") || GLExt::HasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+			GLenum internalFormat = format == BlockFormat::BC1
+				? (srgbBlocks ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+				: (srgbBlocks ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+			if (srgb && !srgbBlocks)
+			{
+				std::cout << "LOG::COOKED_TEXTURE::NO_SRGB_S3TC " << path << " is sampled without linearization" << std::endl;
+			}
+			TextureFormat::Allocate(internalFormat, levelCount, levels[0].width, levels[0].height);
+			for (uint32_t i = 0; i < header->levelCount; i++)
+			{
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, levels[i].width, levels[i].height, internalFormat, (GLsizei)levels[i].size, data + levels[i].offset);
+			}
+		}
+		else
+		{
+			std::cout << "LOG::COOKED_TEXTURE::NO_S3TC decoding the blocks of " << path << std::endl;
+			// decoded blocks are RGBA, the layout the GPU would store anyway
+			TextureFormat pixelFormat = TextureFormat::Choose(4, 8, srgb);
+			TextureFormat::Allocate(pixelFormat.internalFormat, levelCount, levels[0].width, levels[0].height);
+			for (uint32_t i = 0; i < header->levelCount; i++)
+			{
+				std::vector<unsigned char> pixels = BlockCompressor::Decode((const unsigned char*)data + levels[i].offset, levels[i].width, levels[i].height, format);
+				glTexSubImage2D(GL_TEXTURE_2D, (GLint)i, 0, 0, levels[i].width, levels[i].height, pixelFormat.format, pixelFormat.type, pixels.data());
+			}
+		}
+		return texture;
+	}
+
+private:
+	static const char* Magic()
+	{
+		return "LOGLTEX";
+	}
+
+	static uint64_t Align(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// bytes of a row of texels, or of a row of blocks
+	static uint64_t RowSize(uint64_t width, uint64_t channels, BlockFormat format)
+	{
+		return format == BlockFormat::Uncompressed ? width * channels : (width + 3) / 4 * BlockCompressor::BlockBytes(format);
+	}
+
+	static int RowCount(int height, BlockFormat format)
+	{
+		return format == BlockFormat::Uncompressed ? height : (height + 3) / 4;
+	}
+};
+
+#endif // !COOKED_TEXTURE_H
@@ -0,0 +1,435 @@
+#ifndef GPU_MEMORY_H
+#define GPU_MEMORY_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <GLExt.h>
+#include <TextureFormat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <vector>
+
+/// <summary>
+/// Accounts the video memory taken by the textures (every mip level) and buffers registered
+/// with it, and keeps the textures under a budget: when over it, the least recently used ones
+/// lose their top mip level, the oldest first, one level per texture per pass.
+/// A texture is replaced by a smaller one when its top level is dropped, so the samples keep
+/// a handle and ask use() for the current texture object every time they bind it.
+/// </summary>
+class GpuMemory
+{
+public:
+	/// <summary>
+	/// Creates an empty registry
+	/// </summary>
+	/// <param name="budget">Bytes of textures before evicting, 0 uses half the video memory the driver reports (256 MB if it doesn't)</param>
+	/// <param name="minSize">Textures aren't shrunk below this width and height</param>
+	explicit GpuMemory(int64_t budget = 0, int minSize = 64)
+		: budget(budget), minSize(minSize)
+	{
+		if (this->budget <= 0)
+		{
+			int64_t total = QueryTotalMemory();
+			this->budget = total > 0 ? total / 2 : (int64_t)256 << 20;
+		}
+	}
+
+	/// <summary>
+	/// Deletes the textures still registered, the buffers belong to the caller
+	/// </summary>
+	~GpuMemory()
+	{
+		for (const TextureEntry& entry : textures)
+		{
+			if (entry.texture)
+			{
+				glDeleteTextures(1, &entry.texture);
+			}
+		}
+	}
+
+	GpuMemory(const GpuMemory&) = delete;
+	GpuMemory& operator=(const GpuMemory&) = delete;
+
+	/// <summary>
+	/// Takes ownership of a complete texture and accounts its levels
+	/// </summary>
+	/// <param name="texture">Texture object</param>
+	/// <param name="target">GL_TEXTURE_2D textures can be shrunk, the others are only accounted</param>
+	/// <returns>Handle to pass to use(), the handles of removed textures are given again</returns>
+	size_t addTexture(GLuint texture, GLenum target = GL_TEXTURE_2D)
+	{
+		size_t handle = textures.size();
+		if (freeHandles.empty())
+		{
+			textures.emplace_back();
+		}
+		else
+		{
+			handle = freeHandles.back();
+			freeHandles.pop_back();
+		}
+		TextureEntry& entry = textures[handle];
+		entry.texture = texture;
+		entry.target = target;
+		entry.bytes = TextureBytes(texture, target);
+		textureBytes += entry.bytes;
+		lru.push_front(handle);
+		entry.position = lru.begin();
+		return handle;
+	}
+
+	/// <summary>
+	/// Deletes a texture and stops accounting it
+	/// </summary>
+	/// <param name="handle">Value returned by addTexture()</param>
+	void removeTexture(size_t handle)
+	{
+		TextureEntry& entry = textures[handle];
+		if (!entry.texture)
+		{
+			return;
+		}
+		glDeleteTextures(1, &entry.texture);
+		textureBytes -= entry.bytes;
+		lru.erase(entry.position);
+		entry = TextureEntry();
+		freeHandles.push_back(handle);
+	}
+
+	/// <summary>
+	/// Marks a texture as used by the current frame
+	/// </summary>
+	/// <param name="handle">Value returned by addTexture()</param>
+	/// <returns>The texture object to bind, it changes when the texture is shrunk; 0 once removed</returns>
+	GLuint use(size_t handle)
+	{
+		TextureEntry& entry = textures[handle];
+		if (!entry.texture)
+		{
+			// removed: the entry isn't in the lru list
+			return 0;
+		}
+		if (entry.lastUse != frame)
+		{
+			lru.erase(entry.position);
+			lru.push_front(handle);
+			entry.position = lru.begin();
+			entry.lastUse = frame;
+		}
+		return entry.texture;
+	}
+
+	/// <summary>
+	/// Accounts a buffer with its current size, call it again after glBufferData resizes it
+	/// </summary>
+	/// <param name="buffer">Buffer object</param>
+	void addBuffer(GLuint buffer)
+	{
+		removeBuffer(buffer);
+		// the copy binding point isn't part of any VAO state, GL_COPY_READ_BUFFER also queries its binding
+		GLint previous = 0;
+		glGetIntegerv(GL_COPY_READ_BUFFER, &previous);
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		GLint size = 0;
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+		glBindBuffer(GL_COPY_READ_BUFFER, (GLuint)previous);
+		buffers.push_back({ buffer, size });
+		bufferBytes += size;
+	}
+
+	/// <summary>
+	/// Stops accounting a buffer, before deleting it
+	/// </summary>
+	void removeBuffer(GLuint buffer)
+	{
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			if (buffers[i].buffer == buffer)
+			{
+				bufferBytes -= buffers[i].bytes;
+				buffers.erase(buffers.begin() + i);
+				return;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Call once per frame, after its draws: while the textures are over budget the ones
+	/// not used by this frame lose their top mip level, the least recently used first
+	/// </summary>
+	void update()
+	{
+		bool shrunk = true;
+		while (textureBytes > budget && shrunk)
+		{
+			shrunk = false;
+			for (std::list<size_t>::reverse_iterator it = lru.rbegin(); it != lru.rend() && textureBytes > budget; ++it)
+			{
+				TextureEntry& entry = textures[*it];
+				// the rest of the list was used more recently
+				if (entry.lastUse == frame)
+				{
+					break;
+				}
+				shrunk |= dropTopLevel(entry);
+			}
+		}
+		frame++;
+	}
+
+	/// <summary>
+	/// Returns the bytes of the registered textures, every level included
+	/// </summary>
+	int64_t getTextureBytes() const
+	{
+		return textureBytes;
+	}
+
+	/// <summary>
+	/// Returns the bytes of the registered buffers
+	/// </summary>
+	int64_t getBufferBytes() const
+	{
+		return bufferBytes;
+	}
+
+	int64_t getBudget() const
+	{
+		return budget;
+	}
+
+	/// <summary>
+	/// Prints the accounted memory and what the driver reports
+	/// </summary>
+	void print() const
+	{
+		size_t count = 0;
+		for (const TextureEntry& entry : textures)
+		{
+			count += entry.texture != 0;
+		}
+		std::cout << "LOG::GPU_MEMORY::USAGE textures " << textureBytes / 1024 << " KB (" << count << "), buffers "
+			<< bufferBytes / 1024 << " KB (" << buffers.size() << "), budget " << budget / 1024 << " KB";
+		int64_t available = QueryAvailableMemory();
+		if (available >= 0)
+		{
+			std::cout << ", driver reports " << available / 1024 << " KB available";
+		}
+		std::cout << std::endl;
+	}
+
+	/// <summary>
+	/// Returns the video memory still available according to the driver
+	/// (NVX_gpu_memory_info or ATI_meminfo), -1 if it doesn't tell
+	/// </summary>
+	static int64_t QueryAvailableMemory()
+	{
+		GLint kilobytes[4] = {};
+		if (GLExt::HasExtension("GL_NVX_gpu_memory_info"))
+		{
+			glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, kilobytes);
+			return (int64_t)kilobytes[0] * 1024;
+		}
+		if (GLExt::HasExtension("GL_ATI_meminfo"))
+		{
+			// total free, largest free block, total auxiliary free, largest auxiliary free block
+			glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kilobytes);
+			return (int64_t)kilobytes[0] * 1024;
+		}
+		return -1;
+	}
+
+	/// <summary>
+	/// Returns the dedicated video memory according to the driver, -1 if it doesn't tell.
+	/// ATI_meminfo only knows the free memory, which is what it returns
+	/// </summary>
+	static int64_t QueryTotalMemory()
+	{
+		if (GLExt::HasExtension("GL_NVX_gpu_memory_info"))
+		{
+			GLint kilobytes = 0;
+			glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &kilobytes);
+			return (int64_t)kilobytes * 1024;
+		}
+		return QueryAvailableMemory();
+	}
+
+	/// <summary>
+	/// Returns the bytes taken by every level of a texture, from the sizes the driver reports
+	/// </summary>
+	/// <param name="texture">Texture object</param>
+	/// <param name="target">Its target, e.g. GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY</param>
+	static int64_t TextureBytes(GLuint texture, GLenum target)
+	{
+		GLint previous = BoundTexture(target);
+		glBindTexture(target, texture);
+		int64_t bytes = 0;
+		for (GLint level = 0; level < 32; level++)
+		{
+			GLint width = 0, height = 0, depth = 0, compressed = 0;
+			glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
+			if (width == 0)
+			{
+				break;
+			}
+			glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
+			glGetTexLevelParameteriv(target, level, GL_TEXTURE_DEPTH, &depth);
+			glGetTexLevelParameteriv(target, level, GL_TEXTURE_COMPRESSED, &compressed);
+			if (compressed)
+			{
+				GLint size = 0;
+				glGetTexLevelParameteriv(target, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+				bytes += size;
+				continue;
+			}
+			GLint bits = 0;
+			static const GLenum components[] = { GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE,
+				GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE, GL_TEXTURE_STENCIL_SIZE };
+			for (GLenum component : components)
+			{
+				GLint size = 0;
+				glGetTexLevelParameteriv(target, level, component, &size);
+				bits += size;
+			}
+			// three byte texels are stored in four
+			int64_t texelBytes = (bits + 7) / 8;
+			texelBytes = texelBytes == 3 ? 4 : texelBytes;
+			bytes += texelBytes * width * height * std::max(depth, 1);
+		}
+		glBindTexture(target, (GLuint)previous);
+		return bytes;
+	}
+
+private:
+	struct TextureEntry
+	{
+		GLuint texture = 0;
+		GLenum target = GL_TEXTURE_2D;
+		int64_t bytes = 0;
+		uint64_t lastUse = 0;
+		// in the lru list while registered
+		std::list<size_t>::iterator position;
+	};
+
+	struct BufferEntry
+	{
+		GLuint buffer;
+		int64_t bytes;
+	};
+
+	int64_t budget;
+	int minSize;
+	std::vector<TextureEntry> textures;
+	// entries of removed textures, reused by addTexture()
+	std::vector<size_t> freeHandles;
+	std::vector<BufferEntry> buffers;
+	// registered textures, most recently used first
+	std::list<size_t> lru;
+	int64_t textureBytes = 0;
+	int64_t bufferBytes = 0;
+	// starts at 1 so no texture looks used by the current frame before its first use()
+	uint64_t frame = 1;
+
+	static GLint BoundTexture(GLenum target)
+	{
+		GLint texture = 0;
+		glGetIntegerv(target == GL_TEXTURE_2D_ARRAY ? GL_TEXTURE_BINDING_2D_ARRAY : GL_TEXTURE_BINDING_2D, &texture);
+		return texture;
+	}
+
+	// replaces a texture with one made of its levels but the first, false if it can't shrink
+	bool dropTopLevel(TextureEntry& entry)
+	{
+		if (entry.target != GL_TEXTURE_2D)
+		{
+			return false;
+		}
+		GLint previous = BoundTexture(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, entry.texture);
+		GLint width = 0, height = 0, internalFormat = 0, compressed = 0, maxLevel = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+		int levels = 1;
+		while (levels <= maxLevel && levels < 32)
+		{
+			GLint levelWidth = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, levels, GL_TEXTURE_WIDTH, &levelWidth);
+			if (levelWidth == 0)
+			{
+				break;
+			}
+			levels++;
+		}
+		if (levels < 2 || std::max(width, height) / 2 < minSize)
+		{
+			glBindTexture(GL_TEXTURE_2D, (GLuint)previous);
+			return false;
+		}
+
+		// the sampling state moves to the new texture
+		static const GLenum parameters[] = { GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T };
+		GLint values[4];
+		for (int i = 0; i < 4; i++)
+		{
+			glGetTexParameteriv(GL_TEXTURE_2D, parameters[i], &values[i]);
+		}
+
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		TextureFormat::Allocate((GLenum)internalFormat, levels - 1, std::max(width / 2, 1), std::max(height / 2, 1));
+		for (int i = 0; i < 4; i++)
+		{
+			glTexParameteri(GL_TEXTURE_2D, parameters[i], values[i]);
+		}
+		for (int level = 1; level < levels; level++)
+		{
+			GLint levelWidth = 0, levelHeight = 0;
+			glBindTexture(GL_TEXTURE_2D, entry.texture);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &levelWidth);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &levelHeight);
+			if (GLExt::CopyImageSubData)
+			{
+				// stays on the GPU
+				GLExt::CopyImageSubData(entry.texture, GL_TEXTURE_2D, level, 0, 0, 0, texture, GL_TEXTURE_2D, level - 1, 0, 0, 0, levelWidth, levelHeight, 1);
+			}
+			else if (compressed)
+			{
+				GLint size = 0;
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+				std::vector<unsigned char> blocks(size);
+				glGetCompressedTexImage(GL_TEXTURE_2D, level, blocks.data());
+				glBindTexture(GL_TEXTURE_2D, texture);
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, level - 1, 0, 0, levelWidth, levelHeight, (GLenum)internalFormat, size, blocks.data());
+			}
+			else
+			{
+				// a round trip through the CPU, as floats so no format loses precision
+				std::vector<float> pixels((size_t)levelWidth * levelHeight * 4);
+				glPixelStorei(GL_PACK_ALIGNMENT, 4);
+				glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_FLOAT, pixels.data());
+				glBindTexture(GL_TEXTURE_2D, texture);
+				glTexSubImage2D(GL_TEXTURE_2D, level - 1, 0, 0, levelWidth, levelHeight, GL_RGBA, GL_FLOAT, pixels.data());
+			}
+		}
+		glDeleteTextures(1, &entry.texture);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)previous == entry.texture ? texture : (GLuint)previous);
+
+		int64_t bytes = TextureBytes(texture, GL_TEXTURE_2D);
+		std::cout << "LOG::GPU_MEMORY::EVICTED top level of a " << width << "x" << height << " texture, "
+			<< (entry.bytes - bytes) / 1024 << " KB freed" << std::endl;
+		textureBytes += bytes - entry.bytes;
+		entry.bytes = bytes;
+		entry.texture = texture;
+		return true;
+	}
+};
+
+#endif // !GPU_MEMORY_H
@@ -0,0 +1,197 @@
+#ifndef HALF_FLOAT_H
+#define HALF_FLOAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HALF_FLOAT_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles F16C intrinsics without a target flag
+#define HALF_FLOAT_F16C
+#else
+#include <cpuid.h>
+#define HALF_FLOAT_F16C __attribute__((target("avx,f16c")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define HALF_FLOAT_NEON
+#include <arm_neon.h>
+#endif
+
+/// <summary>
+/// IEEE 754 half precision conversions, for HDR pixels uploaded as GL_HALF_FLOAT.
+/// Arrays are converted 8 floats at a time with F16C when the CPU has it (checked at runtime),
+/// with NEON on ARM64, otherwise one at a time; every path rounds to nearest even.
+/// </summary>
+class HalfFloat
+{
+public:
+	/// <summary>
+	/// Converts a float, rounding to nearest even. Larger values become infinity, NaNs stay NaN
+	/// </summary>
+	static uint16_t FromFloat(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000;
+		bits &= 0x7FFFFFFF;
+		uint16_t half;
+		if (bits >= 0x47800000)
+		{
+			// 65536 and above, infinity or NaN
+			half = bits > 0x7F800000 ? 0x7E00 : 0x7C00;
+		}
+		else if (bits < 0x38800000)
+		{
+			// below the smallest normal half: adding 0.5 aligns the 10 mantissa bits at the bottom
+			// of the float, and the addition rounds to nearest even
+			float magic;
+			uint32_t magicBits = 126u << 23;
+			memcpy(&magic, &magicBits, sizeof(magic));
+			float aligned;
+			memcpy(&aligned, &bits, sizeof(aligned));
+			aligned += magic;
+			memcpy(&bits, &aligned, sizeof(bits));
+			half = (uint16_t)(bits - magicBits);
+		}
+		else
+		{
+			// rebias the exponent, add just under half an ulp plus the lowest kept bit, so ties go to even;
+			// a mantissa that overflows carries into the exponent, up to infinity
+			uint32_t odd = (bits >> 13) & 1;
+			bits += ((uint32_t)(15 - 127) << 23) + 0xFFF + odd;
+			half = (uint16_t)(bits >> 13);
+		}
+		return (uint16_t)(half | sign);
+	}
+
+	/// <summary>
+	/// Converts a half back to a float, exactly
+	/// </summary>
+	static float ToFloat(uint16_t half)
+	{
+		uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+		uint32_t exponent = (half >> 10) & 0x1F;
+		uint32_t mantissa = half & 0x3FF;
+		uint32_t bits;
+		if (exponent == 0x1F)
+		{
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+		else
+		{
+			// zero or subnormal: mantissa * 2^-24
+			float value = (float)mantissa * (1.0f / 16777216.0f);
+			memcpy(&bits, &value, sizeof(bits));
+			bits |= sign;
+		}
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	/// <summary>
+	/// Converts an array of floats. The halves may be written over the floats (destination == source),
+	/// which converts a buffer in place without a second allocation
+	/// </summary>
+	/// <param name="source">Floats to convert</param>
+	/// <param name="destination">count halves</param>
+	/// <param name="count">Number of values</param>
+	/// <param name="simd">Use F16C/NEON when available, false runs the scalar reference</param>
+	static void FromFloats(const float* source, uint16_t* destination, size_t count, bool simd = true)
+	{
+		size_t i = 0;
+#if defined(HALF_FLOAT_X86)
+		if (simd && HasF16C())
+		{
+			i = FromFloatsF16C(source, destination, count);
+		}
+#elif defined(HALF_FLOAT_NEON)
+		if (simd)
+		{
+			i = FromFloatsNEON(source, destination, count);
+		}
+#endif
+		// byte copies: in place, the halves and the floats share memory
+		const unsigned char* in = (const unsigned char*)source;
+		unsigned char* out = (unsigned char*)destination;
+		for (; i < count; i++)
+		{
+			float value;
+			memcpy(&value, in + i * sizeof(float), sizeof(value));
+			uint16_t half = FromFloat(value);
+			memcpy(out + i * sizeof(uint16_t), &half, sizeof(half));
+		}
+	}
+
+	/// <summary>
+	/// Returns the instruction set FromFloats() uses: "F16C", "NEON" or "scalar"
+	/// </summary>
+	static const char* InstructionSet()
+	{
+#if defined(HALF_FLOAT_X86)
+		return HasF16C() ? "F16C" : "scalar";
+#elif defined(HALF_FLOAT_NEON)
+		return "NEON";
+#else
+		return "scalar";
+#endif
+	}
+
+private:
+#ifdef HALF_FLOAT_X86
+	static bool HasF16C()
+	{
+		static const bool detected = []()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			// the OS saves the AVX registers
+			bool osxsave = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+			return osxsave && (info[2] & (1 << 29)) != 0;
+#else
+			unsigned int eax, ebx, ecx, edx;
+			// F16C instructions are VEX encoded: AVX support tells the OS saves the registers
+			return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 29)) != 0 && __builtin_cpu_supports("avx");
+#endif
+		}();
+		return detected;
+	}
+
+	// returns the number of values converted, a multiple of 8
+	HALF_FLOAT_F16C static size_t FromFloatsF16C(const float* source, uint16_t* destination, size_t count)
+	{
+		size_t i = 0;
+		// the 16 bytes written never reach the 32 bytes of floats read after them
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128((__m128i*)(destination + i), halves);
+		}
+		return i;
+	}
+#endif
+
+#ifdef HALF_FLOAT_NEON
+	static size_t FromFloatsNEON(const float* source, uint16_t* destination, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			float16x4_t halves = vcvt_f16_f32(vld1q_f32(source + i));
+			vst1_u16(destination + i, vreinterpret_u16_f16(halves));
+		}
+		return i;
+	}
+#endif
+};
+
+#endif // !HALF_FLOAT_H
@@ -0,0 +1,631 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <CpuProfiler.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_GENERATOR_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles AVX2 intrinsics without a target flag
+#define MIP_GENERATOR_AVX2
+#else
+#define MIP_GENERATOR_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define MIP_GENERATOR_NEON
+#include <arm_neon.h>
+#endif
+
+/// <summary>
+/// One level of a mip chain, rows tightly packed
+/// </summary>
+struct MipLevel
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+};
+
+/// <summary>
+/// Downsampling kernel of the mip generator
+/// </summary>
+enum class MipFilter
+{
+	// 2x2 average, what glGenerateMipmap does on most drivers
+	Box,
+	// Kaiser windowed sinc over 8x8 texels, sharper minification with less aliasing
+	Kaiser
+};
+
+/// <summary>
+/// How a mip chain is generated
+/// </summary>
+struct MipSettings
+{
+	MipFilter filter = MipFilter::Box;
+	// the color channels are sRGB encoded: they are averaged in linear space
+	bool srgb = false;
+	// workers filtering bands of rows, NULL runs on the calling thread (which must not be one of the workers)
+	ThreadPool* pool = NULL;
+	// use the SSE2/AVX2/NEON kernels, false runs the scalar reference
+	bool simd = true;
+};
+
+/// <summary>
+/// Builds mip chains on the CPU, so they can be stored instead of generated by the driver.
+/// Every level is filtered from the previous one: the texels are converted to linear
+/// float RGBA a band of rows at a time, filtered vertically then horizontally with a separable
+/// kernel, and converted back to 8 bit. The bands of a level are independent and run on the pool.
+/// </summary>
+class MipGenerator
+{
+public:
+	/// <summary>
+	/// Returns the number of levels of a full chain, down to 1x1
+	/// </summary>
+	static int LevelCount(int width, int height)
+	{
+		int levels = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+			levels++;
+		}
+		return levels;
+	}
+
+	/// <summary>
+	/// Builds the full chain of an 8 bit image, level 0 is a copy of the image
+	/// </summary>
+	/// <param name="pixels">Rows of the image, tightly packed</param>
+	/// <param name="width">Width in pixels</param>
+	/// <param name="height">Height in pixels</param>
+	/// <param name="channels">Bytes per pixel, 1 to 4</param>
+	/// <param name="settings">Filter, color space, threads and SIMD</param>
+	static std::vector<MipLevel> Generate(const unsigned char* pixels, int width, int height, int channels, const MipSettings& settings = MipSettings())
+	{
+		PROFILE_SCOPE("mip generate");
+		std::vector<MipLevel> levels(LevelCount(width, height));
+		levels[0].width = width;
+		levels[0].height = height;
+		levels[0].pixels.assign(pixels, pixels + (size_t)width * height * channels);
+		for (size_t i = 1; i < levels.size(); i++)
+		{
+			const MipLevel& source = levels[i - 1];
+			MipLevel& level = levels[i];
+			level.width = std::max(1, source.width / 2);
+			level.height = std::max(1, source.height / 2);
+			level.pixels.resize((size_t)level.width * level.height * channels);
+			Downsample(source.pixels.data(), source.width, source.height, channels, level.pixels.data(), settings);
+		}
+		return levels;
+	}
+
+	/// <summary>
+	/// Halves an image. Texel pairs start at 0: the box filter drops an odd last row/column like glGenerateMipmap does
+	/// </summary>
+	/// <param name="source">Rows of the image, tightly packed</param>
+	/// <param name="width">Width of the image</param>
+	/// <param name="height">Height of the image</param>
+	/// <param name="channels">Bytes per pixel, 1 to 4</param>
+	/// <param name="destination">Rows of the half size image, tightly packed</param>
+	/// <param name="settings">Filter, color space, threads and SIMD</param>
+	static void Downsample(const unsigned char* source, int width, int height, int channels, unsigned char* destination, const MipSettings& settings = MipSettings())
+	{
+		Pass pass;
+		pass.source = source;
+		pass.width = width;
+		pass.height = height;
+		pass.channels = channels;
+		pass.destination = destination;
+		pass.halfWidth = std::max(1, width / 2);
+		pass.halfHeight = std::max(1, height / 2);
+		pass.kernel = MakeKernel(settings.filter);
+		pass.srgb = settings.srgb;
+		pass.instructions = settings.simd ? Detect() : Instructions::Scalar;
+
+		// the rows are split between the workers, small levels aren't worth the scheduling
+		int parts = 1;
+		if (settings.pool && (size_t)pass.halfWidth * pass.halfHeight >= 128 * 128)
+		{
+			parts = (int)std::min<size_t>(pass.halfHeight, settings.pool->getCount() * 4);
+		}
+		int rows = (pass.halfHeight + parts - 1) / parts;
+		std::vector<std::future<void>> jobs;
+		for (int y = rows; y < pass.halfHeight; y += rows)
+		{
+			int end = std::min(pass.halfHeight, y + rows);
+			jobs.push_back(settings.pool->submit([&pass, y, end]() { FilterRows(pass, y, end); }));
+		}
+		FilterRows(pass, 0, std::min(pass.halfHeight, rows));
+		for (std::future<void>& job : jobs)
+		{
+			job.get();
+		}
+	}
+
+	/// <summary>
+	/// Returns the instruction set used when MipSettings::simd is set: "AVX2", "SSE2", "NEON" or "scalar"
+	/// </summary>
+	static const char* InstructionSet()
+	{
+		switch (Detect())
+		{
+		case Instructions::AVX2:
+			return "AVX2";
+		case Instructions::SSE2:
+			return "SSE2";
+		case Instructions::NEON:
+			return "NEON";
+		default:
+			return "scalar";
+		}
+	}
+
+private:
+	enum class Instructions
+	{
+		Scalar,
+		SSE2,
+		AVX2,
+		NEON
+	};
+
+	// separable kernel: output texel x reads the source texels 2x - offset .. 2x - offset + taps - 1
+	struct Kernel
+	{
+		int taps;
+		int offset;
+		float weights[8];
+	};
+
+	struct Pass
+	{
+		const unsigned char* source;
+		int width;
+		int height;
+		int channels;
+		unsigned char* destination;
+		int halfWidth;
+		int halfHeight;
+		Kernel kernel;
+		bool srgb;
+		Instructions instructions;
+	};
+
+	static const int SRGB_TABLE_SIZE = 16384;
+	static const int BAND_ROWS = 16;
+
+	static Instructions Detect()
+	{
+#if defined(MIP_GENERATOR_X86)
+		static const Instructions detected = HasAVX2() ? Instructions::AVX2 : Instructions::SSE2;
+		return detected;
+#elif defined(MIP_GENERATOR_NEON)
+		return Instructions::NEON;
+#else
+		return Instructions::Scalar;
+#endif
+	}
+
+#ifdef MIP_GENERATOR_X86
+	static bool HasAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		// the OS saves the AVX registers
+		bool osxsave = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		return osxsave && (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	static Kernel MakeKernel(MipFilter filter)
+	{
+		Kernel kernel = {};
+		if (filter == MipFilter::Box)
+		{
+			kernel.taps = 2;
+			kernel.offset = 0;
+			kernel.weights[0] = 0.5f;
+			kernel.weights[1] = 0.5f;
+			return kernel;
+		}
+
+		// sinc of the half resolution, windowed over 2 output texels (4 source texels) on each side
+		const double pi = 3.14159265358979323846;
+		const double alpha = 4.0;
+		kernel.taps = 8;
+		kernel.offset = 3;
+		double sum = 0.0;
+		double weights[8];
+		for (int i = 0; i < kernel.taps; i++)
+		{
+			// distance between the source texel center and the output texel center, in source texels
+			double distance = i - kernel.offset - 0.5;
+			double t = distance / 2.0;
+			double sinc = std::sin(pi * t) / (pi * t);
+			double x = distance / 4.0;
+			double window = BesselI0(alpha * std::sqrt(std::max(0.0, 1.0 - x * x))) / BesselI0(alpha);
+			weights[i] = sinc * window;
+			sum += weights[i];
+		}
+		for (int i = 0; i < kernel.taps; i++)
+		{
+			kernel.weights[i] = (float)(weights[i] / sum);
+		}
+		return kernel;
+	}
+
+	// modified Bessel function of the first kind, order 0
+	static double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// 8 bit to float, [0, 256) sRGB decoded and [256, 512) linear
+	static const float* ToFloatTable()
+	{
+		static const std::vector<float> table = []()
+		{
+			std::vector<float> values(512);
+			for (int i = 0; i < 256; i++)
+			{
+				double c = i / 255.0;
+				values[i] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+				values[256 + i] = (float)c;
+			}
+			return values;
+		}();
+		return table.data();
+	}
+
+	static const unsigned char* ToSrgbTable()
+	{
+		static const std::vector<unsigned char> table = []()
+		{
+			std::vector<unsigned char> values(SRGB_TABLE_SIZE);
+			for (int i = 0; i < SRGB_TABLE_SIZE; i++)
+			{
+				double l = i / (double)(SRGB_TABLE_SIZE - 1);
+				double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+				values[i] = (unsigned char)(c * 255.0 + 0.5);
+			}
+			return values;
+		}();
+		return table.data();
+	}
+
+	// channels converted from sRGB: the color ones, alpha is always linear
+	static int ColorChannels(const Pass& pass)
+	{
+		if (!pass.srgb)
+		{
+			return 0;
+		}
+		return pass.channels == 2 ? 1 : std::min(pass.channels, 3);
+	}
+
+	static void ToFloat(const Pass& pass, const unsigned char* row, float* out)
+	{
+		// one table per channel, so the loop has no branches
+		const float* tables[4];
+		int color = ColorChannels(pass);
+		for (int c = 0; c < 4; c++)
+		{
+			tables[c] = ToFloatTable() + (c < color ? 0 : 256);
+		}
+		if (pass.channels == 4)
+		{
+			for (int x = 0; x < pass.width; x++)
+			{
+				const unsigned char* texel = row + (size_t)x * 4;
+				float* value = out + (size_t)x * 4;
+				value[0] = tables[0][texel[0]];
+				value[1] = tables[1][texel[1]];
+				value[2] = tables[2][texel[2]];
+				value[3] = tables[3][texel[3]];
+			}
+			return;
+		}
+		std::fill(out, out + (size_t)pass.width * 4, 0.0f);
+		for (int x = 0; x < pass.width; x++)
+		{
+			const unsigned char* texel = row + (size_t)x * pass.channels;
+			float* value = out + (size_t)x * 4;
+			for (int c = 0; c < pass.channels; c++)
+			{
+				value[c] = tables[c][texel[c]];
+			}
+		}
+	}
+
+	static void ToBytes(const Pass& pass, const float* row, unsigned char* out)
+	{
+		// sRGB channels index the encoding table, linear ones are the value itself
+		const unsigned char* srgb = ToSrgbTable();
+		int color = ColorChannels(pass);
+		float scales[4];
+		for (int c = 0; c < 4; c++)
+		{
+			scales[c] = c < color ? (float)(SRGB_TABLE_SIZE - 1) : 255.0f;
+		}
+		int indices[4];
+		for (int x = 0; x < pass.halfWidth; x++)
+		{
+			const float* value = row + (size_t)x * 4;
+			// the negative lobes of the Kaiser kernel overshoot
+#ifdef MIP_GENERATOR_X86
+			if (pass.instructions != Instructions::Scalar)
+			{
+				__m128 v = _mm_min_ps(_mm_set1_ps(1.0f), _mm_max_ps(_mm_setzero_ps(), _mm_loadu_ps(value)));
+				v = _mm_add_ps(_mm_mul_ps(v, _mm_loadu_ps(scales)), _mm_set1_ps(0.5f));
+				_mm_storeu_si128((__m128i*)indices, _mm_cvttps_epi32(v));
+			}
+			else
+#endif
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					float v = std::min(1.0f, std::max(0.0f, value[c]));
+					indices[c] = (int)(v * scales[c] + 0.5f);
+				}
+			}
+			unsigned char* texel = out + (size_t)x * pass.channels;
+			for (int c = 0; c < pass.channels; c++)
+			{
+				texel[c] = c < color ? srgb[indices[c]] : (unsigned char)indices[c];
+			}
+		}
+	}
+
+	// filters the output rows [begin, end), a band of BAND_ROWS at a time
+	static void FilterRows(const Pass& pass, int begin, int end)
+	{
+		const Kernel& kernel = pass.kernel;
+		size_t rowFloats = (size_t)pass.width * 4;
+
+		// float copy of the source rows read by a band, small enough to stay in the cache
+		std::vector<float> rows((size_t)std::min(pass.height, 2 * BAND_ROWS + kernel.taps) * rowFloats);
+		// vertically filtered row, with the edge texels repeated on both sides for the horizontal pass
+		int pad = kernel.taps;
+		std::vector<float> padded((size_t)(pass.width + 2 * pad) * 4);
+		std::vector<float> output((size_t)pass.halfWidth * 4);
+		for (int band = begin; band < end; band += BAND_ROWS)
+		{
+			FilterBand(pass, band, std::min(end, band + BAND_ROWS), rows.data(), padded.data(), output.data());
+		}
+	}
+
+	static void FilterBand(const Pass& pass, int begin, int end, float* rows, float* padded, float* output)
+	{
+		const Kernel& kernel = pass.kernel;
+		size_t rowFloats = (size_t)pass.width * 4;
+
+		// source rows read by the band, converted once
+		int first = std::max(0, 2 * begin - kernel.offset);
+		int last = std::min(pass.height - 1, 2 * (end - 1) - kernel.offset + kernel.taps - 1);
+		for (int y = first; y <= last; y++)
+		{
+			ToFloat(pass, pass.source + (size_t)y * pass.width * pass.channels, rows + (size_t)(y - first) * rowFloats);
+		}
+
+		int pad = kernel.taps;
+		const float* taps[8];
+		for (int y = begin; y < end; y++)
+		{
+			for (int i = 0; i < kernel.taps; i++)
+			{
+				int row = std::min(pass.height - 1, std::max(0, 2 * y - kernel.offset + i));
+				taps[i] = rows + (size_t)(row - first) * rowFloats;
+			}
+			float* center = padded + (size_t)pad * 4;
+			Vertical(pass.instructions, kernel, taps, center, rowFloats);
+			for (int x = 0; x < pad; x++)
+			{
+				std::copy(center, center + 4, padded + (size_t)x * 4);
+				std::copy(center + rowFloats - 4, center + rowFloats, center + rowFloats + (size_t)x * 4);
+			}
+
+			// with an odd width the texel pairs still start at 0, the last column only feeds the wider kernels
+			Horizontal(pass.instructions, kernel, center - (size_t)kernel.offset * 4, output, pass.halfWidth);
+			ToBytes(pass, output, pass.destination + (size_t)y * pass.halfWidth * pass.channels);
+		}
+	}
+
+	// out[i] = sum of weights[t] * taps[t][i]
+	static void Vertical(Instructions instructions, const Kernel& kernel, const float* const* taps, float* out, size_t count)
+	{
+		switch (instructions)
+		{
+#ifdef MIP_GENERATOR_X86
+		case Instructions::AVX2:
+			VerticalAVX2(kernel, taps, out, count);
+			return;
+		case Instructions::SSE2:
+			VerticalSSE2(kernel, taps, out, count);
+			return;
+#endif
+#ifdef MIP_GENERATOR_NEON
+		case Instructions::NEON:
+			VerticalNEON(kernel, taps, out, count);
+			return;
+#endif
+		default:
+			VerticalScalar(kernel, taps, out, 0, count);
+			return;
+		}
+	}
+
+	// out texel x = sum of weights[t] * row texel (2x + t), the row starts at the first texel read
+	static void Horizontal(Instructions instructions, const Kernel& kernel, const float* row, float* out, int count)
+	{
+		switch (instructions)
+		{
+#ifdef MIP_GENERATOR_X86
+		case Instructions::AVX2:
+			HorizontalAVX2(kernel, row, out, count);
+			return;
+		case Instructions::SSE2:
+			HorizontalSSE2(kernel, row, out, 0, count);
+			return;
+#endif
+#ifdef MIP_GENERATOR_NEON
+		case Instructions::NEON:
+			HorizontalNEON(kernel, row, out, count);
+			return;
+#endif
+		default:
+			HorizontalScalar(kernel, row, out, 0, count);
+			return;
+		}
+	}
+
+	static void VerticalScalar(const Kernel& kernel, const float* const* taps, float* out, size_t begin, size_t count)
+	{
+		for (size_t i = begin; i < count; i++)
+		{
+			float sum = kernel.weights[0] * taps[0][i];
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = sum + kernel.weights[t] * taps[t][i];
+			}
+			out[i] = sum;
+		}
+	}
+
+	static void HorizontalScalar(const Kernel& kernel, const float* row, float* out, int begin, int count)
+	{
+		for (int x = begin; x < count; x++)
+		{
+			const float* texel = row + (size_t)x * 8;
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = kernel.weights[0] * texel[c];
+				for (int t = 1; t < kernel.taps; t++)
+				{
+					sum = sum + kernel.weights[t] * texel[t * 4 + c];
+				}
+				out[(size_t)x * 4 + c] = sum;
+			}
+		}
+	}
+
+#ifdef MIP_GENERATOR_X86
+	static void VerticalSSE2(const Kernel& kernel, const float* const* taps, float* out, size_t count)
+	{
+		// count is a multiple of 4: one RGBA texel per register
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(kernel.weights[0]), _mm_loadu_ps(taps[0] + i));
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[t]), _mm_loadu_ps(taps[t] + i)));
+			}
+			_mm_storeu_ps(out + i, sum);
+		}
+	}
+
+	static void HorizontalSSE2(const Kernel& kernel, const float* row, float* out, int begin, int count)
+	{
+		for (int x = begin; x < count; x++)
+		{
+			const float* texel = row + (size_t)x * 8;
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(kernel.weights[0]), _mm_loadu_ps(texel));
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[t]), _mm_loadu_ps(texel + t * 4)));
+			}
+			_mm_storeu_ps(out + (size_t)x * 4, sum);
+		}
+	}
+
+	MIP_GENERATOR_AVX2 static void VerticalAVX2(const Kernel& kernel, const float* const* taps, float* out, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 sum = _mm256_mul_ps(_mm256_set1_ps(kernel.weights[0]), _mm256_loadu_ps(taps[0] + i));
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel.weights[t]), _mm256_loadu_ps(taps[t] + i)));
+			}
+			_mm256_storeu_ps(out + i, sum);
+		}
+		VerticalScalar(kernel, taps, out, i, count);
+	}
+
+	MIP_GENERATOR_AVX2 static void HorizontalAVX2(const Kernel& kernel, const float* row, float* out, int count)
+	{
+		// two output texels per register: the low half reads texel 2x + t, the high half 2x + 2 + t
+		int x = 0;
+		for (; x + 2 <= count; x += 2)
+		{
+			const float* texel = row + (size_t)x * 8;
+			__m256 sum = _mm256_mul_ps(_mm256_set1_ps(kernel.weights[0]), Load2(texel, texel + 8));
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel.weights[t]), Load2(texel + t * 4, texel + 8 + t * 4)));
+			}
+			_mm256_storeu_ps(out + (size_t)x * 4, sum);
+		}
+		HorizontalSSE2(kernel, row, out, x, count);
+	}
+
+	MIP_GENERATOR_AVX2 static __m256 Load2(const float* low, const float* high)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+	}
+#endif
+
+#ifdef MIP_GENERATOR_NEON
+	static void VerticalNEON(const Kernel& kernel, const float* const* taps, float* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i += 4)
+		{
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(taps[0] + i), kernel.weights[0]);
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(taps[t] + i), kernel.weights[t]));
+			}
+			vst1q_f32(out + i, sum);
+		}
+	}
+
+	static void HorizontalNEON(const Kernel& kernel, const float* row, float* out, int count)
+	{
+		for (int x = 0; x < count; x++)
+		{
+			const float* texel = row + (size_t)x * 8;
+			float32x4_t sum = vmulq_n_f32(vld1q_f32(texel), kernel.weights[0]);
+			for (int t = 1; t < kernel.taps; t++)
+			{
+				sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(texel + t * 4), kernel.weights[t]));
+			}
+			vst1q_f32(out + (size_t)x * 4, sum);
+		}
+	}
+#endif
+};
+
+#endif // !MIP_GENERATOR_H
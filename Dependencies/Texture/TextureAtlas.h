@@ -0,0 +1,424 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <TextureFormat.h>
+#include <TextureLoader.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+struct AtlasRect
+{
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+/// <summary>
+/// Skyline bottom-left rectangle packer: the packed area is described by the top edge of
+/// its columns, and each rectangle goes where its top ends lowest (ties broken by the
+/// least space wasted under it). Fast and tight enough for sprites sorted by height.
+/// </summary>
+class SkylinePacker
+{
+public:
+	SkylinePacker(int width, int height)
+		: width(width), height(height)
+	{
+		skyline.push_back({ 0, 0, width });
+	}
+
+	/// <summary>
+	/// Places a rectangle
+	/// </summary>
+	/// <param name="rectWidth">Width of the rectangle</param>
+	/// <param name="rectHeight">Height of the rectangle</param>
+	/// <param name="rect">Position and size of the placed rectangle</param>
+	/// <returns>False if it doesn't fit anymore</returns>
+	bool insert(int rectWidth, int rectHeight, AtlasRect& rect)
+	{
+		size_t best = skyline.size();
+		int bestY = height;
+		int bestWaste = 0;
+		for (size_t i = 0; i < skyline.size(); i++)
+		{
+			int waste;
+			int y = fit(i, rectWidth, rectHeight, waste);
+			if (y >= 0 && (y < bestY || (y == bestY && waste < bestWaste)))
+			{
+				best = i;
+				bestY = y;
+				bestWaste = waste;
+			}
+		}
+		if (best == skyline.size())
+		{
+			return false;
+		}
+		rect = { skyline[best].x, bestY, rectWidth, rectHeight };
+		usedArea += (size_t)rectWidth * rectHeight;
+
+		// the new segment covers the ones under the rectangle, the last of them is cut
+		skyline.insert(skyline.begin() + best, { rect.x, bestY + rectHeight, rectWidth });
+		size_t next = best + 1;
+		while (next < skyline.size() && skyline[next].x < rect.x + rectWidth)
+		{
+			int overlap = rect.x + rectWidth - skyline[next].x;
+			if (overlap < skyline[next].width)
+			{
+				skyline[next].x += overlap;
+				skyline[next].width -= overlap;
+				break;
+			}
+			skyline.erase(skyline.begin() + next);
+		}
+		merge();
+		return true;
+	}
+
+	/// <summary>
+	/// Returns the fraction of the area taken by rectangles
+	/// </summary>
+	float getOccupancy() const
+	{
+		return (float)usedArea / ((float)width * height);
+	}
+
+	/// <summary>
+	/// Returns the extent of the packed rectangles
+	/// </summary>
+	void getUsedSize(int& usedWidth, int& usedHeight) const
+	{
+		usedWidth = 0;
+		usedHeight = 0;
+		for (const Segment& segment : skyline)
+		{
+			if (segment.y > 0)
+			{
+				usedWidth = std::max(usedWidth, segment.x + segment.width);
+				usedHeight = std::max(usedHeight, segment.y);
+			}
+		}
+	}
+
+private:
+	struct Segment
+	{
+		int x;
+		int y;
+		int width;
+	};
+
+	int width;
+	int height;
+	size_t usedArea = 0;
+	std::vector<Segment> skyline;
+
+	// top of a rectangle whose left edge is at segment index, -1 if it doesn't fit there
+	int fit(size_t index, int rectWidth, int rectHeight, int& waste) const
+	{
+		int x = skyline[index].x;
+		if (x + rectWidth > width)
+		{
+			return -1;
+		}
+		// the rectangle rests on the highest segment it spans
+		int y = 0;
+		int remaining = rectWidth;
+		for (size_t i = index; remaining > 0; i++)
+		{
+			y = std::max(y, skyline[i].y);
+			remaining -= skyline[i].width;
+		}
+		if (y + rectHeight > height)
+		{
+			return -1;
+		}
+		waste = 0;
+		remaining = rectWidth;
+		for (size_t i = index; remaining > 0; i++)
+		{
+			waste += (y - skyline[i].y) * std::min(remaining, skyline[i].width);
+			remaining -= skyline[i].width;
+		}
+		return y;
+	}
+
+	void merge()
+	{
+		for (size_t i = 0; i + 1 < skyline.size();)
+		{
+			if (skyline[i].y == skyline[i + 1].y)
+			{
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+};
+
+/// <summary>
+/// Where an image ended up in the atlas: sample at
+/// vec3(offset + uv * scale, layer) instead of uv
+/// </summary>
+struct AtlasRegion
+{
+	int layer;
+	float offset[2];
+	float scale[2];
+};
+
+/// <summary>
+/// Packs many images into the layers of one GL_TEXTURE_2D_ARRAY, so quads with different
+/// images are drawn with a single bind and a single (instanced) draw call, each one remapping
+/// its texture coordinates with the AtlasRegion of its image.
+/// Images are surrounded by a gutter repeating their edge texels, so bilinear filtering and the
+/// first mip levels don't bleed the neighbours in; the mip chain stops before the gutter vanishes.
+/// </summary>
+class TextureAtlas
+{
+public:
+	/// <summary>
+	/// Creates an empty atlas
+	/// </summary>
+	/// <param name="layerSize">Width and height of the layers, images larger than that can't be added</param>
+	/// <param name="padding">Gutter around each image in texels, a power of two</param>
+	explicit TextureAtlas(int layerSize = 2048, int padding = 4)
+		: layerSize(layerSize), padding(padding)
+	{
+	}
+
+	~TextureAtlas()
+	{
+		if (texture)
+		{
+			glDeleteTextures(1, &texture);
+		}
+	}
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	/// <summary>
+	/// Adds an image, its pixels are copied
+	/// </summary>
+	/// <param name="pixels">Rows tightly packed</param>
+	/// <param name="width">Width of the image</param>
+	/// <param name="height">Height of the image</param>
+	/// <param name="channels">1 to 4, the atlas is RGBA (grey is replicated, missing alpha is opaque)</param>
+	/// <returns>Handle to pass to getRegion()</returns>
+	size_t add(const unsigned char* pixels, int width, int height, int channels)
+	{
+		Entry entry;
+		entry.width = width;
+		entry.height = height;
+		entry.pixels.resize((size_t)width * height * 4);
+		for (size_t i = 0; i < (size_t)width * height; i++)
+		{
+			const unsigned char* source = pixels + i * channels;
+			unsigned char* destination = entry.pixels.data() + i * 4;
+			destination[0] = source[0];
+			destination[1] = channels >= 3 ? source[1] : source[0];
+			destination[2] = channels >= 3 ? source[2] : source[0];
+			destination[3] = channels == 4 ? source[3] : channels == 2 ? source[1] : 255;
+		}
+		entries.push_back(std::move(entry));
+		return entries.size() - 1;
+	}
+
+	/// <summary>
+	/// Adds a decoded image, its pixels are copied
+	/// </summary>
+	/// <returns>Handle to pass to getRegion()</returns>
+	size_t add(const Image& image)
+	{
+		return add(image.getPixels(), image.getWidth(), image.getHeight(), image.getChannels());
+	}
+
+	/// <summary>
+	/// Packs the images and uploads them to a new texture array, left bound.
+	/// Call it once every image is added: the CPU copies are freed afterwards
+	/// </summary>
+	/// <param name="mipmaps">Generate the mip levels the gutter allows</param>
+	/// <param name="srgb">The images hold sRGB colors</param>
+	/// <returns>False if an image is larger than a layer, its region has layer -1</returns>
+	bool build(bool mipmaps = true, bool srgb = false)
+	{
+		// the gutter halves at every level: stop while it's still a texel wide,
+		// and keep the images on multiples of the last level's texel so levels don't shift them
+		int levels = 1;
+		while (mipmaps && (padding >> levels) > 0)
+		{
+			levels++;
+		}
+		int alignment = 1 << (levels - 1);
+
+		// tallest images first: the skyline stays flat
+		std::vector<size_t> order(entries.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [this](size_t a, size_t b)
+		{
+			return entries[a].height != entries[b].height ? entries[a].height > entries[b].height : entries[a].width > entries[b].width;
+		});
+
+		bool success = true;
+		std::vector<SkylinePacker> packers;
+		std::vector<AtlasRect> rects(entries.size());
+		regions.assign(entries.size(), AtlasRegion{ -1, { 0.0f, 0.0f }, { 0.0f, 0.0f } });
+		for (size_t index : order)
+		{
+			int width = Align(entries[index].width + 2 * padding, alignment);
+			int height = Align(entries[index].height + 2 * padding, alignment);
+			if (width > layerSize || height > layerSize)
+			{
+				std::cout << "ERROR::TEXTURE_ATLAS::TOO_LARGE " << entries[index].width << "x" << entries[index].height
+					<< " doesn't fit a " << layerSize << "x" << layerSize << " layer" << std::endl;
+				success = false;
+				continue;
+			}
+			// first fit over the layers, a new one when it fits nowhere
+			size_t layer = 0;
+			while (layer < packers.size() && !packers[layer].insert(width, height, rects[index]))
+			{
+				layer++;
+			}
+			if (layer == packers.size())
+			{
+				packers.emplace_back(layerSize, layerSize);
+				packers.back().insert(width, height, rects[index]);
+			}
+			regions[index].layer = (int)layer;
+		}
+
+		// a single layer shrinks to what it uses
+		int atlasWidth = layerSize;
+		int atlasHeight = layerSize;
+		if (packers.size() == 1)
+		{
+			packers[0].getUsedSize(atlasWidth, atlasHeight);
+		}
+		layerCount = (int)std::max<size_t>(packers.size(), 1);
+		atlasWidth = std::max(atlasWidth, alignment);
+		atlasHeight = std::max(atlasHeight, alignment);
+
+		TextureFormat format = TextureFormat::Choose(4, 8, srgb);
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		TextureFormat::AllocateArray(format.internalFormat, levels, atlasWidth, atlasHeight, layerCount);
+
+		// layers are composed on the CPU and uploaded whole, the gaps between images are transparent
+		std::vector<unsigned char> pixels((size_t)atlasWidth * atlasHeight * 4);
+		for (int layer = 0; layer < layerCount; layer++)
+		{
+			std::fill(pixels.begin(), pixels.end(), (unsigned char)0);
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				if (regions[i].layer == layer)
+				{
+					blit(entries[i], rects[i].x + padding, rects[i].y + padding, pixels.data(), atlasWidth);
+					regions[i].offset[0] = (float)(rects[i].x + padding) / atlasWidth;
+					regions[i].offset[1] = (float)(rects[i].y + padding) / atlasHeight;
+					regions[i].scale[0] = (float)entries[i].width / atlasWidth;
+					regions[i].scale[1] = (float)entries[i].height / atlasHeight;
+				}
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, atlasWidth, atlasHeight, 1, format.format, format.type, pixels.data());
+		}
+		if (levels > 1)
+		{
+			glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		}
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		// of the uploaded texels
+		float occupancy = 0.0f;
+		for (const SkylinePacker& packer : packers)
+		{
+			occupancy += packer.getOccupancy() * ((float)layerSize * layerSize) / ((float)atlasWidth * atlasHeight * layerCount);
+		}
+		std::cout << "LOG::TEXTURE_ATLAS::BUILT " << entries.size() << " images in " << layerCount << " layers of "
+			<< atlasWidth << "x" << atlasHeight << ", " << levels << " levels, " << (int)(occupancy * 100.0f) << "% occupied" << std::endl;
+
+		entries.clear();
+		entries.shrink_to_fit();
+		return success;
+	}
+
+	/// <summary>
+	/// Returns the texture coordinate remapping of an image, valid after build()
+	/// </summary>
+	/// <param name="handle">Value returned by add()</param>
+	const AtlasRegion& getRegion(size_t handle) const
+	{
+		return regions[handle];
+	}
+
+	/// <summary>
+	/// Returns the GL_TEXTURE_2D_ARRAY, 0 before build()
+	/// </summary>
+	GLuint getTexture() const
+	{
+		return texture;
+	}
+
+	int getLayerCount() const
+	{
+		return layerCount;
+	}
+
+private:
+	struct Entry
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	int layerSize;
+	int padding;
+	GLuint texture = 0;
+	int layerCount = 0;
+	std::vector<Entry> entries;
+	std::vector<AtlasRegion> regions;
+
+	static int Align(int value, int alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// copies an image at x, y and extrudes its edge texels into the gutter
+	void blit(const Entry& entry, int x, int y, unsigned char* layer, int layerWidth) const
+	{
+		for (int row = -padding; row < entry.height + padding; row++)
+		{
+			const unsigned char* source = entry.pixels.data() + (size_t)std::min(std::max(row, 0), entry.height - 1) * entry.width * 4;
+			unsigned char* destination = layer + ((size_t)(y + row) * layerWidth + x) * 4;
+			// left gutter, the row, right gutter
+			for (int column = -padding; column < 0; column++)
+			{
+				memcpy(destination + column * 4, source, 4);
+			}
+			memcpy(destination, source, (size_t)entry.width * 4);
+			for (int column = entry.width; column < entry.width + padding; column++)
+			{
+				memcpy(destination + column * 4, source + (entry.width - 1) * 4, 4);
+			}
+		}
+	}
+};
+
+#endif // !TEXTURE_ATLAS_H
@@ -0,0 +1,227 @@
+#ifndef TEXTURE_FORMAT_H
+#define TEXTURE_FORMAT_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <GLExt.h>
+
+#include <algorithm>
+#include <cstddef>
+
+/// <summary>
+/// Type of the channels of decoded pixels
+/// </summary>
+enum class PixelType
+{
+	// 8 bit normalized, LDR images
+	UnsignedByte,
+	// 16 bit normalized, 16 bit PNGs
+	UnsignedShort,
+	// IEEE half floats, HDR images
+	HalfFloat
+};
+
+/// <summary>
+/// Format negotiation for texture uploads: picks a sized internal format for the channels,
+/// bit depth and color space of the pixels, and the client format/type that matches it exactly,
+/// so the driver copies the rows instead of converting them.
+/// Storage is allocated immutable (glTexStorage2D) when the context has it.
+/// </summary>
+struct TextureFormat
+{
+	GLenum internalFormat;
+	// client layout of the pixels handed to glTexSubImage2D
+	GLenum format;
+	GLenum type;
+	int channels;
+	int bytesPerPixel;
+
+	/// <summary>
+	/// Chooses the formats of an uncompressed texture
+	/// </summary>
+	/// <param name="channels">Channels of the pixels, 1 to 4</param>
+	/// <param name="bitDepth">Bits per channel, 8 or 16</param>
+	/// <param name="srgb">The color channels are sRGB encoded: the GPU linearizes them when sampling (8 bit RGB/RGBA only)</param>
+	static TextureFormat Choose(int channels, int bitDepth = 8, bool srgb = false)
+	{
+		channels = std::min(std::max(channels, 1), 4);
+		TextureFormat result;
+		result.channels = channels;
+		result.format = channels == 1 ? GL_RED : channels == 2 ? GL_RG : channels == 3 ? GL_RGB : GL_RGBA;
+		if (bitDepth == 16)
+		{
+			static const GLenum formats[] = { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 };
+			result.internalFormat = formats[channels - 1];
+			result.type = GL_UNSIGNED_SHORT;
+			result.bytesPerPixel = channels * 2;
+		}
+		else
+		{
+			// core GL has no sRGB one and two channel formats
+			static const GLenum formats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+			static const GLenum srgbFormats[] = { GL_R8, GL_RG8, GL_SRGB8, GL_SRGB8_ALPHA8 };
+			result.internalFormat = srgb ? srgbFormats[channels - 1] : formats[channels - 1];
+			result.type = GL_UNSIGNED_BYTE;
+			result.bytesPerPixel = channels;
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Chooses the formats of an uncompressed texture from the type of the pixels:
+	/// GL_RGBA16F for half floats, which sample as HDR values
+	/// </summary>
+	/// <param name="channels">Channels of the pixels, 1 to 4</param>
+	/// <param name="type">Type of the channels</param>
+	/// <param name="srgb">The color channels are sRGB encoded (8 bit RGB/RGBA only)</param>
+	static TextureFormat Choose(int channels, PixelType type, bool srgb = false)
+	{
+		if (type != PixelType::HalfFloat)
+		{
+			return Choose(channels, type == PixelType::UnsignedShort ? 16 : 8, srgb);
+		}
+		channels = std::min(std::max(channels, 1), 4);
+		static const GLenum formats[] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
+		TextureFormat result;
+		result.channels = channels;
+		result.format = channels == 1 ? GL_RED : channels == 2 ? GL_RG : channels == 3 ? GL_RGB : GL_RGBA;
+		result.internalFormat = formats[channels - 1];
+		result.type = GL_HALF_FLOAT;
+		result.bytesPerPixel = channels * 2;
+		return result;
+	}
+
+	/// <summary>
+	/// Returns the channels to decode an image with before uploading it: GPUs store RGB8 as RGBA8,
+	/// so three channel pixels would be widened by the driver on every upload
+	/// </summary>
+	/// <param name="channels">Channels of the image file</param>
+	static int UploadChannels(int channels)
+	{
+		return channels == 3 ? 4 : channels;
+	}
+
+	/// <summary>
+	/// Returns the largest GL_UNPACK_ALIGNMENT that tightly packed rows satisfy
+	/// </summary>
+	/// <param name="rowSize">Bytes of a row</param>
+	static GLint UnpackAlignment(size_t rowSize)
+	{
+		return rowSize % 8 == 0 ? 8 : rowSize % 4 == 0 ? 4 : rowSize % 2 == 0 ? 2 : 1;
+	}
+
+	/// <summary>
+	/// Returns the number of levels of a full mip chain
+	/// </summary>
+	static int LevelCount(int width, int height)
+	{
+		int levels = 1;
+		while (width > 1 || height > 1)
+		{
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+			levels++;
+		}
+		return levels;
+	}
+
+	/// <summary>
+	/// Allocates the levels of the bound GL_TEXTURE_2D, filled afterwards with glTexSubImage2D
+	/// (or glCompressedTexSubImage2D). Immutable storage with ARB_texture_storage, otherwise every
+	/// level is specified with glTexImage2D and GL_TEXTURE_MAX_LEVEL ends the chain
+	/// </summary>
+	/// <param name="internalFormat">Sized internal format, compressed ones included</param>
+	/// <param name="levels">Number of mip levels</param>
+	/// <param name="width">Width of level 0</param>
+	/// <param name="height">Height of level 0</param>
+	static void Allocate(GLenum internalFormat, int levels, int width, int height)
+	{
+		AllocateLevels(GL_TEXTURE_2D, internalFormat, levels, width, height, 0);
+	}
+
+	/// <summary>
+	/// Allocates the levels of the bound GL_TEXTURE_2D_ARRAY, filled afterwards with glTexSubImage3D
+	/// </summary>
+	/// <param name="internalFormat">Sized internal format</param>
+	/// <param name="levels">Number of mip levels</param>
+	/// <param name="width">Width of level 0</param>
+	/// <param name="height">Height of level 0</param>
+	/// <param name="layers">Number of layers</param>
+	static void AllocateArray(GLenum internalFormat, int levels, int width, int height, int layers)
+	{
+		AllocateLevels(GL_TEXTURE_2D_ARRAY, internalFormat, levels, width, height, layers);
+	}
+
+	/// <summary>
+	/// Makes one and two channel textures of the bound target sample as grey and grey + alpha
+	/// (R,R,R,1 and R,R,R,G) instead of red and red + green; done by Allocate() and AllocateArray()
+	/// </summary>
+	/// <param name="target">Bound texture target</param>
+	/// <param name="internalFormat">Sized internal format of the texture</param>
+	static void SetSwizzle(GLenum target, GLenum internalFormat)
+	{
+		bool grey = internalFormat == GL_R8 || internalFormat == GL_R16;
+		bool greyAlpha = internalFormat == GL_RG8 || internalFormat == GL_RG16;
+		if (!grey && !greyAlpha)
+		{
+			return;
+		}
+		GLint swizzle[] = { GL_RED, GL_RED, GL_RED, grey ? GL_ONE : GL_GREEN };
+		glTexParameteriv(target, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+	}
+
+private:
+	static void AllocateLevels(GLenum target, GLenum internalFormat, int levels, int width, int height, int layers)
+	{
+		// NULL would be an offset into a bound pixel buffer
+		GLint pbo = 0;
+		glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &pbo);
+		if (pbo)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		if (target == GL_TEXTURE_2D && GLExt::TexStorage2D)
+		{
+			GLExt::TexStorage2D(target, levels, internalFormat, width, height);
+		}
+		else if (target == GL_TEXTURE_2D_ARRAY && GLExt::TexStorage3D)
+		{
+			GLExt::TexStorage3D(target, levels, internalFormat, width, height, layers);
+		}
+		else
+		{
+			// any format/type pair the internal format accepts will do: no pixels are transferred
+			GLenum format = GL_RGBA;
+			GLenum type = GL_UNSIGNED_BYTE;
+			if (internalFormat == GL_R8 || internalFormat == GL_R16)
+			{
+				format = GL_RED;
+			}
+			else if (internalFormat == GL_RG8 || internalFormat == GL_RG16)
+			{
+				format = GL_RG;
+			}
+			for (int level = 0; level < levels; level++)
+			{
+				if (target == GL_TEXTURE_2D_ARRAY)
+				{
+					glTexImage3D(target, level, internalFormat, width, height, layers, 0, format, type, NULL);
+				}
+				else
+				{
+					glTexImage2D(target, level, internalFormat, width, height, 0, format, type, NULL);
+				}
+				width = std::max(width / 2, 1);
+				height = std::max(height / 2, 1);
+			}
+		}
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		SetSwizzle(target, internalFormat);
+		if (pbo)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, (GLuint)pbo);
+		}
+	}
+};
+
+#endif // !TEXTURE_FORMAT_H
@@ -0,0 +1,310 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <CpuProfiler.h>
+#include <HalfFloat.h>
+#include <TextureFormat.h>
+#include <ThreadPool.h>
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Pixels decoded by stb_image, freed with stbi_image_free when the image is destroyed.
+/// 8 bit unless decoded with highPrecision: HDR files become half floats, 16 bit files stay 16 bit
+/// </summary>
+class Image
+{
+public:
+	// desiredChannels that keeps the channels of the file but widens RGB to RGBA, the layout GPUs store
+	static const int UPLOAD_CHANNELS = -1;
+
+	Image() = default;
+
+	~Image()
+	{
+		release();
+	}
+
+	Image(const Image&) = delete;
+	Image& operator=(const Image&) = delete;
+
+	Image(Image&& other) noexcept
+		: path(std::move(other.path)), pixels(other.pixels), width(other.width), height(other.height),
+		channels(other.channels), type(other.type), decodeTime(other.decodeTime), error(other.error)
+	{
+		other.pixels = NULL;
+	}
+
+	Image& operator=(Image&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release();
+			path = std::move(other.path);
+			pixels = other.pixels;
+			width = other.width;
+			height = other.height;
+			channels = other.channels;
+			type = other.type;
+			decodeTime = other.decodeTime;
+			error = other.error;
+			other.pixels = NULL;
+		}
+		return *this;
+	}
+
+	/// <summary>
+	/// Decodes an image file, check isValid() for errors
+	/// </summary>
+	/// <param name="path">Image file path</param>
+	/// <param name="desiredChannels">Channels of the result, 0 keeps the ones of the file, UPLOAD_CHANNELS widens RGB to RGBA</param>
+	/// <param name="flip">Flip vertically, OpenGL expects the first row at the bottom</param>
+	/// <param name="highPrecision">Keep the range of HDR files (as half floats) and the depth of 16 bit files, otherwise everything is 8 bit</param>
+	static Image Decode(const std::string& path, int desiredChannels = 0, bool flip = false, bool highPrecision = false)
+	{
+		PROFILE_SCOPE("texture decode");
+		Image image;
+		image.path = path;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		// the flip flag and the failure reason are per thread
+		stbi_set_flip_vertically_on_load_thread(flip);
+		int fileChannels;
+		if (desiredChannels == UPLOAD_CHANNELS)
+		{
+			// only the header is parsed, a file it can't read fails again in stbi_load with the reason
+			int width, height;
+			desiredChannels = stbi_info(path.c_str(), &width, &height, &fileChannels) ? TextureFormat::UploadChannels(fileChannels) : 0;
+		}
+		if (highPrecision && stbi_is_hdr(path.c_str()))
+		{
+			float* floats = stbi_loadf(path.c_str(), &image.width, &image.height, &fileChannels, desiredChannels);
+			if (floats)
+			{
+				// the halves are written over the floats, the second half of the buffer is given back
+				// (stb_image.cpp checks that stb_image allocates with malloc, so realloc is valid here)
+				size_t count = (size_t)image.width * image.height * (desiredChannels ? desiredChannels : fileChannels);
+				HalfFloat::FromFloats(floats, (uint16_t*)floats, count);
+				void* halves = realloc(floats, count * sizeof(uint16_t));
+				image.pixels = (unsigned char*)(halves ? halves : floats);
+				image.type = PixelType::HalfFloat;
+			}
+		}
+		else if (highPrecision && stbi_is_16_bit(path.c_str()))
+		{
+			image.pixels = (unsigned char*)stbi_load_16(path.c_str(), &image.width, &image.height, &fileChannels, desiredChannels);
+			image.type = PixelType::UnsignedShort;
+		}
+		else
+		{
+			image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &fileChannels, desiredChannels);
+		}
+		image.channels = desiredChannels ? desiredChannels : fileChannels;
+		image.decodeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (!image.pixels)
+		{
+			image.error = stbi_failure_reason();
+		}
+		return image;
+	}
+
+	/// <summary>
+	/// Frees the pixels, e.g. once they are uploaded
+	/// </summary>
+	void release()
+	{
+		if (pixels)
+		{
+			stbi_image_free(pixels);
+			pixels = NULL;
+		}
+	}
+
+	bool isValid() const
+	{
+		return pixels != NULL;
+	}
+
+	const std::string& getPath() const
+	{
+		return path;
+	}
+
+	const unsigned char* getPixels() const
+	{
+		return pixels;
+	}
+
+	int getWidth() const
+	{
+		return width;
+	}
+
+	int getHeight() const
+	{
+		return height;
+	}
+
+	int getChannels() const
+	{
+		return channels;
+	}
+
+	PixelType getType() const
+	{
+		return type;
+	}
+
+	/// <summary>
+	/// Returns the bytes of a pixel: channels times 1, or 2 for 16 bit and half float images
+	/// </summary>
+	int getBytesPerPixel() const
+	{
+		return type == PixelType::UnsignedByte ? channels : channels * 2;
+	}
+
+	/// <summary>
+	/// Returns the time spent decoding, in milliseconds
+	/// </summary>
+	double getDecodeTime() const
+	{
+		return decodeTime;
+	}
+
+	/// <summary>
+	/// Returns the reason given by stb_image when decoding failed
+	/// </summary>
+	const char* getError() const
+	{
+		return error ? error : "";
+	}
+
+private:
+	std::string path;
+	unsigned char* pixels = NULL;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	PixelType type = PixelType::UnsignedByte;
+	double decodeTime = 0.0;
+	const char* error = NULL;
+};
+
+/// <summary>
+/// Decodes images on a pool of worker threads and uploads them as textures.
+/// Decoding runs in parallel while the render thread keeps working,
+/// only the upload needs the GL context and must happen on its thread.
+/// </summary>
+class TextureLoader
+{
+public:
+	/// <summary>
+	/// Starts the decoding workers
+	/// </summary>
+	/// <param name="threads">Number of workers, 0 uses one per core minus the render thread</param>
+	explicit TextureLoader(unsigned int threads = 0)
+		: pool(threads)
+	{
+	}
+
+	/// <summary>
+	/// Queues the decoding of an image
+	/// </summary>
+	/// <param name="path">Image file path</param>
+	/// <param name="desiredChannels">Channels of the result, 0 keeps the ones of the file, UPLOAD_CHANNELS widens RGB to RGBA</param>
+	/// <param name="flip">Flip vertically, OpenGL expects the first row at the bottom</param>
+	/// <param name="highPrecision">Keep the range of HDR files (as half floats) and the depth of 16 bit files</param>
+	std::future<Image> load(const std::string& path, int desiredChannels = Image::UPLOAD_CHANNELS, bool flip = false, bool highPrecision = false)
+	{
+		return pool.submit([path, desiredChannels, flip, highPrecision]() { return Image::Decode(path, desiredChannels, flip, highPrecision); });
+	}
+
+	/// <summary>
+	/// Queues the decoding of several images, they are decoded concurrently
+	/// </summary>
+	/// <param name="paths">Image file paths</param>
+	/// <param name="desiredChannels">Channels of the results, 0 keeps the ones of the files, UPLOAD_CHANNELS widens RGB to RGBA</param>
+	/// <param name="flip">Flip vertically, OpenGL expects the first row at the bottom</param>
+	/// <param name="highPrecision">Keep the range of HDR files (as half floats) and the depth of 16 bit files</param>
+	std::vector<std::future<Image>> loadAll(const std::vector<std::string>& paths, int desiredChannels = Image::UPLOAD_CHANNELS, bool flip = false, bool highPrecision = false)
+	{
+		std::vector<std::future<Image>> images;
+		images.reserve(paths.size());
+		for (const std::string& path : paths)
+		{
+			images.push_back(load(path, desiredChannels, flip, highPrecision));
+		}
+		return images;
+	}
+
+	/// <summary>
+	/// Waits for a decoded image and uploads it, the CPU pixels are freed afterwards
+	/// </summary>
+	/// <param name="image">Future returned by load()</param>
+	/// <param name="mipmaps">Generate the mipmap chain</param>
+	/// <param name="srgb">The image holds sRGB colors, stored as GL_SRGB8_ALPHA8 so sampling returns linear values</param>
+	/// <returns>Texture object, 0 if the image couldn't be decoded</returns>
+	static GLuint Upload(std::future<Image>& image, bool mipmaps = true, bool srgb = false)
+	{
+		Image decoded = image.get();
+		return Upload(decoded, mipmaps, srgb);
+	}
+
+	/// <summary>
+	/// Uploads a decoded image to a new GL_TEXTURE_2D, the CPU pixels are freed afterwards.
+	/// The texture is left bound
+	/// </summary>
+	/// <param name="image">Decoded image</param>
+	/// <param name="mipmaps">Generate the mipmap chain</param>
+	/// <param name="srgb">The image holds sRGB colors, stored as GL_SRGB8_ALPHA8 so sampling returns linear values (8 bit images only)</param>
+	/// <returns>Texture object, 0 if the image couldn't be decoded</returns>
+	static GLuint Upload(Image& image, bool mipmaps = true, bool srgb = false)
+	{
+		if (!image.isValid())
+		{
+			std::cout << "ERROR::TEXTURE::LOAD_FAILED " << image.getPath() << " " << image.getError() << std::endl;
+			return 0;
+		}
+		PROFILE_SCOPE("texture upload");
+		std::cout << "LOG::TEXTURE::DECODED " << image.getPath() << " " << image.getWidth() << "x" << image.getHeight()
+			<< "x" << image.getChannels() << " in " << image.getDecodeTime() << " ms" << std::endl;
+
+		// half floats go as they are to GL_RGBA16F: half the memory and upload bandwidth of 32 bit floats
+		TextureFormat format = TextureFormat::Choose(image.getChannels(), image.getType(), srgb);
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		TextureFormat::Allocate(format.internalFormat, mipmaps ? TextureFormat::LevelCount(image.getWidth(), image.getHeight()) : 1, image.getWidth(), image.getHeight());
+		// stb_image rows are tightly packed
+		glPixelStorei(GL_UNPACK_ALIGNMENT, TextureFormat::UnpackAlignment((size_t)image.getWidth() * format.bytesPerPixel));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.getWidth(), image.getHeight(), format.format, format.type, image.getPixels());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		if (mipmaps)
+		{
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		// the driver has its own copy now
+		image.release();
+		return texture;
+	}
+
+	/// <summary>
+	/// Returns the number of decoding workers
+	/// </summary>
+	size_t getThreadCount() const
+	{
+		return pool.getCount();
+	}
+
+private:
+	ThreadPool pool;
+};
+
+#endif // !TEXTURE_LOADER_H
@@ -0,0 +1,402 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <CpuProfiler.h>
+#include <GLExt.h>
+#include <TextureFormat.h>
+#include <TextureLoader.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Streams textures to the GPU without stalling the render loop.
+/// Workers decode the images and copy their rows into a ring of staging memory that
+/// is persistently mapped (ARB_buffer_storage); once per frame the render thread issues
+/// glTexSubImage2D from that pixel buffer for at most a budget of bytes, and fences
+/// tell when the GPU is done reading a part of the ring so it can be reused.
+/// Without buffer storage the ring lives in client memory and is uploaded from there.
+/// </summary>
+class TextureStreamer
+{
+public:
+	/// <summary>
+	/// Creates the staging ring and starts the workers, needs a current context
+	/// </summary>
+	/// <param name="stagingSize">Size of the staging ring in bytes</param>
+	/// <param name="frameBudget">Bytes uploaded per frame at most (at least one slice is always uploaded)</param>
+	/// <param name="threads">Number of workers, 0 uses one per core minus the render thread</param>
+	TextureStreamer(size_t stagingSize = 16 << 20, size_t frameBudget = 4 << 20, unsigned int threads = 0)
+		: capacity(stagingSize), frameBudget(frameBudget)
+	{
+		if (GLExt::BufferStorage)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glGenBuffers(1, &pbo);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+			GLExt::BufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)capacity, NULL, flags);
+			staging = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)capacity, flags);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			if (!staging)
+			{
+				glDeleteBuffers(1, &pbo);
+				pbo = 0;
+			}
+		}
+		if (!staging)
+		{
+			clientStaging.resize(capacity);
+			staging = clientStaging.data();
+		}
+		pool.reset(new ThreadPool(threads));
+	}
+
+	/// <summary>
+	/// Stops the workers and frees the staging ring.
+	/// Textures that were not completely uploaded are deleted, the others belong to the caller
+	/// </summary>
+	~TextureStreamer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		space.notify_all();
+		// the workers write into the ring: join them before unmapping it
+		pool.reset();
+
+		for (const Fence& fence : fences)
+		{
+			glDeleteSync(fence.sync);
+		}
+		if (pbo)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &pbo);
+		}
+		for (const std::unique_ptr<Request>& request : requests)
+		{
+			if (!request->done && request->texture)
+			{
+				glDeleteTextures(1, &request->texture);
+			}
+		}
+	}
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	/// <summary>
+	/// Queues an image, it's decoded and uploaded in the background
+	/// </summary>
+	/// <param name="path">Image file path</param>
+	/// <param name="desiredChannels">Channels of the result, 0 keeps the ones of the file, UPLOAD_CHANNELS widens RGB to RGBA</param>
+	/// <param name="flip">Flip vertically, OpenGL expects the first row at the bottom</param>
+	/// <param name="srgb">The image holds sRGB colors, stored as GL_SRGB8_ALPHA8 so sampling returns linear values</param>
+	/// <param name="highPrecision">Keep the range of HDR files (uploaded as GL_RGBA16F) and the depth of 16 bit files</param>
+	/// <returns>Handle to pass to getTexture()</returns>
+	size_t load(const std::string& path, int desiredChannels = Image::UPLOAD_CHANNELS, bool flip = false, bool srgb = false, bool highPrecision = false)
+	{
+		requests.emplace_back(new Request());
+		Request* request = requests.back().get();
+		request->srgb = srgb;
+		pool->submit([this, request, path, desiredChannels, flip, highPrecision]()
+		{
+			// requests still queued when the streamer is destroyed are dropped
+			if (!isStopping())
+			{
+				stage(request, Image::Decode(path, desiredChannels, flip, highPrecision));
+			}
+		});
+		return requests.size() - 1;
+	}
+
+	/// <summary>
+	/// Call once per frame on the render thread: recycles the staging memory the GPU
+	/// is done with and uploads the staged rows within the frame budget
+	/// </summary>
+	void update()
+	{
+		PROFILE_SCOPE("texture stream");
+		std::vector<Slice> uploads;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			retireFences();
+
+			// slices are uploaded in the order they were allocated so the ring is freed in order
+			size_t bytes = 0;
+			while (!slices.empty() && slices.front().ready)
+			{
+				size_t size = slices.front().size;
+				if (!uploads.empty() && bytes + size > frameBudget)
+				{
+					break;
+				}
+				bytes += size;
+				uploads.push_back(slices.front());
+				slices.pop_front();
+			}
+			PROFILE_COUNTER("streamed bytes", bytes);
+		}
+		if (uploads.empty())
+		{
+			return;
+		}
+
+		size_t span = 0;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		for (const Slice& slice : uploads)
+		{
+			span += slice.span;
+			upload(slice);
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pbo)
+		{
+			fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), span });
+		}
+		else
+		{
+			// client memory is copied by glTexSubImage2D before it returns
+			used -= span;
+			space.notify_all();
+		}
+	}
+
+	/// <summary>
+	/// Returns the texture of a request once it's completely uploaded, 0 until then
+	/// </summary>
+	/// <param name="handle">Value returned by load()</param>
+	GLuint getTexture(size_t handle) const
+	{
+		const Request& request = *requests[handle];
+		return request.done ? request.texture : 0;
+	}
+
+	/// <summary>
+	/// Returns true when every request was uploaded (or failed)
+	/// </summary>
+	bool isIdle() const
+	{
+		for (const std::unique_ptr<Request>& request : requests)
+		{
+			if (!request->done && !request->failed)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Returns true if the staging ring is a persistently mapped pixel buffer
+	/// </summary>
+	bool isPersistent() const
+	{
+		return pbo != 0;
+	}
+
+private:
+	// state of a texture, written by the render thread only
+	struct Request
+	{
+		GLuint texture = 0;
+		bool srgb = false;
+		int rowsUploaded = 0;
+		bool done = false;
+		bool failed = false;
+	};
+
+	// rows of an image copied into the ring
+	struct Slice
+	{
+		Request* request;
+		std::shared_ptr<Image> image;
+		size_t offset;
+		// bytes of pixels, and bytes of ring taken including the padding skipped at the end of the ring
+		size_t size;
+		size_t span;
+		int firstRow;
+		int rows;
+		bool ready;
+	};
+
+	struct Fence
+	{
+		GLsync sync;
+		size_t span;
+	};
+
+	size_t capacity;
+	size_t frameBudget;
+	GLuint pbo = 0;
+	unsigned char* staging = NULL;
+	std::vector<unsigned char> clientStaging;
+
+	std::vector<std::unique_ptr<Request>> requests;
+
+	// ring allocation, guarded by the mutex
+	std::mutex mutex;
+	std::condition_variable space;
+	size_t head = 0;
+	size_t used = 0;
+	std::deque<Slice> slices;
+	std::deque<Fence> fences;
+	bool stopping = false;
+
+	std::unique_ptr<ThreadPool> pool;
+
+	// worker side: copies the rows of a decoded image into the ring, slice by slice
+	void stage(Request* request, Image decoded)
+	{
+		std::shared_ptr<Image> image = std::make_shared<Image>(std::move(decoded));
+		size_t rowSize = (size_t)image->getWidth() * image->getBytesPerPixel();
+		// a slice never exceeds the frame budget, nor a quarter of the ring so several can be in flight
+		size_t maxRows = std::min(frameBudget, capacity / 4) / std::max<size_t>(1, rowSize);
+		if (rowSize > capacity)
+		{
+			// can't be staged: an empty slice reports the failure
+			image->release();
+		}
+		else if (maxRows == 0)
+		{
+			maxRows = 1;
+		}
+
+		int row = 0;
+		int rows;
+		do
+		{
+			rows = image->isValid() ? (int)std::min<size_t>(maxRows, image->getHeight() - row) : 0;
+			size_t size = rows * rowSize;
+			Slice* slice;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				size_t offset = 0;
+				size_t span = 0;
+				space.wait(lock, [&]() { return stopping || allocate(size, offset, span); });
+				if (stopping)
+				{
+					return;
+				}
+				slices.push_back({ request, image, offset, size, span, row, rows, false });
+				// deque elements don't move when pushing at the back or popping at the front
+				slice = &slices.back();
+			}
+			if (size > 0)
+			{
+				memcpy(staging + slice->offset, image->getPixels() + row * rowSize, size);
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				slice->ready = true;
+			}
+			row += rows;
+		} while (rows > 0 && row < image->getHeight());
+		// everything is staged, only the size of the image is still needed
+		image->release();
+	}
+
+	bool isStopping()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return stopping;
+	}
+
+	// takes size bytes from the ring, 16 byte aligned, wrapping to the start if they don't fit at the end
+	bool allocate(size_t size, size_t& offset, size_t& span)
+	{
+		size = (size + 15) & ~(size_t)15;
+		if (used == 0)
+		{
+			// nothing in flight: start over, a slice larger than the end of the ring must still fit
+			head = 0;
+		}
+		offset = head + size <= capacity ? head : 0;
+		span = offset == head ? size : capacity - head + size;
+		if (used + span > capacity)
+		{
+			return false;
+		}
+		head = offset + size == capacity ? 0 : offset + size;
+		used += span;
+		return true;
+	}
+
+	// render side: frees the parts of the ring read by finished uploads
+	void retireFences()
+	{
+		bool freed = false;
+		while (!fences.empty())
+		{
+			GLenum status = glClientWaitSync(fences.front().sync, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			{
+				break;
+			}
+			glDeleteSync(fences.front().sync);
+			used -= fences.front().span;
+			fences.pop_front();
+			freed = true;
+		}
+		if (freed)
+		{
+			space.notify_all();
+		}
+	}
+
+	void upload(const Slice& slice)
+	{
+		Request& request = *slice.request;
+		const Image& image = *slice.image;
+		if (slice.rows == 0)
+		{
+			const char* error = image.getError()[0] ? image.getError() : "rows larger than the staging ring";
+			std::cout << "ERROR::TEXTURE::LOAD_FAILED " << image.getPath() << " " << error << std::endl;
+			request.failed = true;
+			return;
+		}
+
+		TextureFormat format = TextureFormat::Choose(image.getChannels(), image.getType(), request.srgb);
+		if (!request.texture)
+		{
+			std::cout << "LOG::TEXTURE::DECODED " << image.getPath() << " " << image.getWidth() << "x" << image.getHeight()
+				<< "x" << image.getChannels() << " in " << image.getDecodeTime() << " ms" << std::endl;
+			glGenTextures(1, &request.texture);
+			glBindTexture(GL_TEXTURE_2D, request.texture);
+			// the whole chain up front, glGenerateMipmap fills it once the last rows arrive
+			TextureFormat::Allocate(format.internalFormat, TextureFormat::LevelCount(image.getWidth(), image.getHeight()), image.getWidth(), image.getHeight());
+		}
+		glBindTexture(GL_TEXTURE_2D, request.texture);
+		// staged rows are tightly packed and start 16 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, TextureFormat::UnpackAlignment((size_t)image.getWidth() * format.bytesPerPixel));
+		// with a pixel buffer bound the pointer is an offset into it
+		const void* pixels = pbo ? (const void*)(uintptr_t)slice.offset : staging + slice.offset;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, slice.firstRow, image.getWidth(), slice.rows, format.format, format.type, pixels);
+
+		request.rowsUploaded += slice.rows;
+		if (request.rowsUploaded == image.getHeight())
+		{
+			glGenerateMipmap(GL_TEXTURE_2D);
+			request.done = true;
+		}
+	}
+};
+
+#endif // !TEXTURE_STREAMER_H
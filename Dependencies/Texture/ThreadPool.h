@@ -0,0 +1,116 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <CpuProfiler.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// Fixed set of worker threads running submitted jobs in FIFO order.
+/// Every job returns a future, so the caller waits only for the results it needs.
+/// </summary>
+class ThreadPool
+{
+public:
+	/// <summary>
+	/// Starts the workers
+	/// </summary>
+	/// <param name="count">Number of workers, 0 uses one per core minus the render thread</param>
+	explicit ThreadPool(unsigned int count = 0)
+	{
+		if (count == 0)
+		{
+			// hardware_concurrency() may return 0 when unknown
+			count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+		}
+		for (unsigned int i = 0; i < count; i++)
+		{
+			workers.emplace_back(&ThreadPool::work, this);
+		}
+	}
+
+	/// <summary>
+	/// Finishes the queued jobs and joins the workers
+	/// </summary>
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// <summary>
+	/// Queues a job
+	/// </summary>
+	/// <param name="job">Callable without arguments</param>
+	/// <returns>Future of the job's result, exceptions are forwarded to it</returns>
+	template <typename Job>
+	std::future<std::invoke_result_t<Job>> submit(Job&& job)
+	{
+		using Result = std::invoke_result_t<Job>;
+		// std::function needs a copyable callable: share the task
+		std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::forward<Job>(job));
+		std::future<Result> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			jobs.emplace([task]() { (*task)(); });
+		}
+		wake.notify_one();
+		return result;
+	}
+
+	/// <summary>
+	/// Returns the number of workers
+	/// </summary>
+	size_t getCount() const
+	{
+		return workers.size();
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+
+	void work()
+	{
+		PROFILE_THREAD("worker");
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (jobs.empty())
+				{
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop();
+			}
+			job();
+		}
+	}
+};
+
+#endif // !THREAD_POOL_H
@@ -0,0 +1,658 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <glad/glad.h> // include glad to get all the required OpenGL headers
+
+#include <CpuProfiler.h>
+#include <MappedFile.h>
+#include <MipGenerator.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/// <summary>
+/// Virtual texture: an image of any size cooked by the TextureCooker into fixed size pages
+/// (.vtex, every mip level cut into pageSize squares with a border copied from the neighbours),
+/// of which only the pages the camera needs are in video memory.
+/// Every frame a low resolution feedback pass writes the page each pixel samples; the pages
+/// missing from the page cache texture are read from the mapped file by a worker thread and
+/// uploaded within a budget, evicting the least recently used ones. An indirection texture
+/// (one layer per level, one texel per page) tells the shader where a page lives in the cache,
+/// or points at the closest resident ancestor while it's loading.
+/// Video memory is the cache plus the indirection, whatever the size of the image.
+/// </summary>
+class VirtualTexture
+{
+public:
+	static const uint32_t VERSION = 1;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t pageSize;
+		uint32_t border;
+		uint32_t levelCount;
+		uint32_t pageCount;
+		uint32_t padding;
+	};
+
+	struct Level
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t pagesX;
+		uint32_t pagesY;
+		uint32_t firstPage;
+	};
+
+	/// <summary>
+	/// Cuts a mip chain into pages and writes them, through a temporary file
+	/// </summary>
+	/// <param name="path">Output file path</param>
+	/// <param name="levels">RGBA mip chain, rows tightly packed</param>
+	/// <param name="pageSize">Texels per page side, without the border</param>
+	/// <param name="border">Texels repeated from the neighbour pages on each side, for filtering</param>
+	/// <returns>False if the file can't be written</returns>
+	static bool Write(const std::string& path, const std::vector<MipLevel>& levels, int pageSize = 128, int border = 2)
+	{
+		Header header = {};
+		memcpy(header.magic, Magic(), sizeof(header.magic));
+		header.version = VERSION;
+		header.width = levels[0].width;
+		header.height = levels[0].height;
+		header.pageSize = pageSize;
+		header.border = border;
+
+		// the chain stops at the first level that fits a single page: it's always resident
+		std::vector<Level> table;
+		uint32_t pageCount = 0;
+		for (const MipLevel& level : levels)
+		{
+			Level entry;
+			entry.width = level.width;
+			entry.height = level.height;
+			entry.pagesX = (level.width + pageSize - 1) / pageSize;
+			entry.pagesY = (level.height + pageSize - 1) / pageSize;
+			entry.firstPage = pageCount;
+			pageCount += entry.pagesX * entry.pagesY;
+			table.push_back(entry);
+			if (entry.pagesX == 1 && entry.pagesY == 1)
+			{
+				break;
+			}
+		}
+		header.levelCount = (uint32_t)table.size();
+		header.pageCount = pageCount;
+
+		std::string temporary = path + ".tmp";
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)table.data(), sizeof(Level) * table.size());
+		static const char zeros[16] = {};
+		file.write(zeros, DataOffset(header.levelCount) - sizeof(Header) - sizeof(Level) * table.size());
+
+		int paddedSize = pageSize + 2 * border;
+		std::vector<unsigned char> page((size_t)paddedSize * paddedSize * 4);
+		for (size_t l = 0; l < table.size(); l++)
+		{
+			const MipLevel& level = levels[l];
+			for (uint32_t py = 0; py < table[l].pagesY; py++)
+			{
+				for (uint32_t px = 0; px < table[l].pagesX; px++)
+				{
+					// texels outside the image repeat its edge, like GL_CLAMP_TO_EDGE
+					for (int y = 0; y < paddedSize; y++)
+					{
+						int sy = std::min(std::max((int)(py * pageSize) + y - border, 0), level.height - 1);
+						for (int x = 0; x < paddedSize; x++)
+						{
+							int sx = std::min(std::max((int)(px * pageSize) + x - border, 0), level.width - 1);
+							memcpy(&page[((size_t)y * paddedSize + x) * 4], &level.pixels[((size_t)sy * level.width + sx) * 4], 4);
+						}
+					}
+					file.write((const char*)page.data(), page.size());
+				}
+			}
+		}
+		file.close();
+		if (!file)
+		{
+			std::remove(temporary.c_str());
+			return false;
+		}
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		return !error;
+	}
+
+	/// <summary>
+	/// Maps a .vtex file and creates the page cache, the indirection and the feedback targets.
+	/// The last level is loaded right away so there's always something to sample
+	/// </summary>
+	/// <param name="path">.vtex file path</param>
+	/// <param name="cacheSlots">The page cache holds cacheSlots x cacheSlots pages, 2 to 256</param>
+	/// <param name="feedbackScale">The feedback pass renders at 1/feedbackScale of the viewport</param>
+	/// <param name="threads">Page loading workers</param>
+	explicit VirtualTexture(const std::string& path, int cacheSlots = 8, int feedbackScale = 4, unsigned int threads = 1)
+		: file(path.c_str()), cacheSlots(std::min(std::max(cacheSlots, 2), 256)), feedbackScale(std::max(feedbackScale, 1))
+	{
+		const Header* header = (const Header*)file.getData();
+		if (!file.isOpen() || file.getSize() < sizeof(Header) || memcmp(header->magic, Magic(), sizeof(header->magic)) != 0
+			|| header->version != VERSION || header->levelCount == 0 || header->levelCount > 32 || header->pageSize == 0
+			|| file.getSize() < DataOffset(header->levelCount) + (uint64_t)header->pageCount * PageBytes(*header))
+		{
+			std::cout << "ERROR::VIRTUAL_TEXTURE::INVALID_FILE " << path << std::endl;
+			return;
+		}
+		this->header = *header;
+		const Level* table = (const Level*)(file.getData() + sizeof(Header));
+		levels.assign(table, table + header->levelCount);
+		const Level& last = levels.back();
+		if (!ValidLevels(*header, levels) || last.pagesX != 1 || last.pagesY != 1)
+		{
+			std::cout << "ERROR::VIRTUAL_TEXTURE::INVALID_FILE " << path << std::endl;
+			return;
+		}
+
+		// page cache: the pages keep their border so bilinear filtering never crosses into a neighbour slot
+		glGenTextures(1, &cache);
+		glBindTexture(GL_TEXTURE_2D, cache);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, getCacheSize(), getCacheSize(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		slots.resize((size_t)this->cacheSlots * this->cacheSlots);
+
+		// indirection: a layer per level as large as level 0 in pages, read with texelFetch
+		indirectionData.assign((size_t)levels[0].pagesX * levels[0].pagesY * levels.size() * 4, 0);
+		glGenTextures(1, &indirection);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, indirection);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8UI, levels[0].pagesX, levels[0].pagesY, (GLsizei)levels.size(), 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		// feedback: page coordinates and level per pixel, read back a frame later through pixel buffers
+		glGenFramebuffers(1, &feedbackFramebuffer);
+		glGenRenderbuffers(2, feedbackRenderbuffers);
+		glGenBuffers(2, feedbackBuffers);
+
+		// the single page of the last level is the fallback of every other page
+		std::vector<unsigned char> root(PageBytes(this->header));
+		readPage(last.firstPage, root.data());
+		pageSlots.assign(header->pageCount, -1);
+		slots[0].page = last.firstPage;
+		slots[0].pinned = true;
+		pageSlots[last.firstPage] = 0;
+		residentCount = 1;
+		uploadPage(0, root.data());
+		updateIndirection();
+
+		pool.reset(new ThreadPool(threads));
+		valid = true;
+	}
+
+	/// <summary>
+	/// Waits for the page loads in flight and deletes the GL objects
+	/// </summary>
+	~VirtualTexture()
+	{
+		// the workers read from the mapped file
+		pool.reset();
+		glDeleteTextures(1, &cache);
+		glDeleteTextures(1, &indirection);
+		glDeleteFramebuffers(1, &feedbackFramebuffer);
+		glDeleteRenderbuffers(2, feedbackRenderbuffers);
+		glDeleteBuffers(2, feedbackBuffers);
+	}
+
+	VirtualTexture(const VirtualTexture&) = delete;
+	VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	/// <summary>
+	/// Binds the low resolution feedback target and clears it: draw the scene with the feedback
+	/// shader (same vertices, a fragment shader writing VirtualFeedback()), then call endFeedback()
+	/// </summary>
+	void beginFeedback()
+	{
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+		int width = std::max(1, viewport[2] / feedbackScale);
+		int height = std::max(1, viewport[3] / feedbackScale);
+		if (width != feedbackWidth || height != feedbackHeight)
+		{
+			feedbackWidth = width;
+			feedbackHeight = height;
+			// page x, y, level and a written flag, 16 bit so huge images fit
+			glBindRenderbuffer(GL_RENDERBUFFER, feedbackRenderbuffers[0]);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, feedbackRenderbuffers[1]);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+			glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, feedbackRenderbuffers[0]);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedbackRenderbuffers[1]);
+			for (int i = 0; i < 2; i++)
+			{
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackBuffers[i]);
+				glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 8, NULL, GL_STREAM_READ);
+				feedbackPending[i] = false;
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, feedbackFramebuffer);
+		glViewport(0, 0, feedbackWidth, feedbackHeight);
+		static const GLuint clear[4] = { 0, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 0, clear);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	/// <summary>
+	/// Queues the read back of the feedback, without waiting for it, and restores the framebuffer
+	/// </summary>
+	void endFeedback()
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, feedbackBuffers[feedbackIndex]);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(0, 0, feedbackWidth, feedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		feedbackPending[feedbackIndex] = true;
+		feedbackIndex ^= 1;
+		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+
+	/// <summary>
+	/// Call once per frame after endFeedback(): reads the feedback of the previous frame,
+	/// queues the missing pages and uploads the loaded ones
+	/// </summary>
+	/// <param name="uploadBudget">Pages uploaded per frame at most</param>
+	void update(int uploadBudget = 8)
+	{
+		PROFILE_SCOPE("virtual texture update");
+		frame++;
+		// the buffer written a frame ago is done by now, mapping it doesn't stall
+		if (feedbackPending[feedbackIndex])
+		{
+			readFeedback(feedbackBuffers[feedbackIndex]);
+			feedbackPending[feedbackIndex] = false;
+		}
+
+		std::vector<LoadedPage> uploads;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			// coarse levels first: they cover more of the screen
+			std::sort(loaded.begin(), loaded.end(), [](const LoadedPage& a, const LoadedPage& b) { return a.page > b.page; });
+			size_t count = std::min(loaded.size(), (size_t)uploadBudget);
+			uploads.assign(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.begin() + count));
+			loaded.erase(loaded.begin(), loaded.begin() + count);
+		}
+		bool changed = false;
+		for (LoadedPage& page : uploads)
+		{
+			pending.erase(page.page);
+			int slot = evict();
+			if (slot < 0)
+			{
+				// every page is needed by the current view: the cache is too small for it
+				continue;
+			}
+			slots[slot].page = page.page;
+			slots[slot].lastUse = frame;
+			pageSlots[page.page] = slot;
+			residentCount++;
+			uploadPage(slot, page.pixels.data());
+			changed = true;
+		}
+		if (changed)
+		{
+			updateIndirection();
+		}
+		PROFILE_COUNTER("resident pages", residentCount);
+	}
+
+	/// <summary>
+	/// Binds the page cache and the indirection to two texture units
+	/// </summary>
+	void bind(GLuint cacheUnit, GLuint indirectionUnit) const
+	{
+		glActiveTexture(GL_TEXTURE0 + indirectionUnit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, indirection);
+		glActiveTexture(GL_TEXTURE0 + cacheUnit);
+		glBindTexture(GL_TEXTURE_2D, cache);
+	}
+
+	/// <summary>
+	/// Sets the uniforms of virtual.glsl on the program in use
+	/// </summary>
+	/// <param name="program">Program including virtual.glsl</param>
+	/// <param name="cacheUnit">Texture unit of the page cache given to bind()</param>
+	/// <param name="indirectionUnit">Texture unit of the indirection given to bind()</param>
+	/// <param name="feedback">The program draws the feedback pass</param>
+	void setUniforms(GLuint program, GLuint cacheUnit, GLuint indirectionUnit, bool feedback) const
+	{
+		glUniform1i(glGetUniformLocation(program, "uVirtualCache"), cacheUnit);
+		glUniform1i(glGetUniformLocation(program, "uVirtualIndirection"), indirectionUnit);
+		glUniform2i(glGetUniformLocation(program, "uVirtualSize"), header.width, header.height);
+		glUniform1i(glGetUniformLocation(program, "uVirtualPageSize"), header.pageSize);
+		glUniform1i(glGetUniformLocation(program, "uVirtualBorder"), header.border);
+		glUniform1i(glGetUniformLocation(program, "uVirtualLevels"), header.levelCount);
+		glUniform1f(glGetUniformLocation(program, "uVirtualCacheSize"), (float)getCacheSize());
+		glUniform1f(glGetUniformLocation(program, "uVirtualBias"), feedback ? getFeedbackBias() : 0.0f);
+	}
+
+	int getWidth() const
+	{
+		return header.width;
+	}
+
+	int getHeight() const
+	{
+		return header.height;
+	}
+
+	int getPageSize() const
+	{
+		return header.pageSize;
+	}
+
+	int getBorder() const
+	{
+		return header.border;
+	}
+
+	int getLevelCount() const
+	{
+		return header.levelCount;
+	}
+
+	int getPaddedPageSize() const
+	{
+		return header.pageSize + 2 * header.border;
+	}
+
+	/// <summary>
+	/// Returns the width and height of the page cache texture in texels
+	/// </summary>
+	int getCacheSize() const
+	{
+		return cacheSlots * getPaddedPageSize();
+	}
+
+	/// <summary>
+	/// Returns the level bias of the feedback pass, its derivatives are feedbackScale times larger
+	/// </summary>
+	float getFeedbackBias() const
+	{
+		return -std::log2((float)feedbackScale);
+	}
+
+	/// <summary>
+	/// Returns the number of pages in the cache
+	/// </summary>
+	size_t getResidentCount() const
+	{
+		return residentCount;
+	}
+
+private:
+	struct Slot
+	{
+		int64_t page = -1;
+		uint64_t lastUse = 0;
+		bool pinned = false;
+	};
+
+	struct LoadedPage
+	{
+		uint32_t page;
+		std::vector<unsigned char> pixels;
+	};
+
+	MappedFile file;
+	Header header = {};
+	std::vector<Level> levels;
+	bool valid = false;
+	int cacheSlots;
+	int feedbackScale;
+
+	GLuint cache = 0;
+	GLuint indirection = 0;
+	std::vector<unsigned char> indirectionData;
+	std::vector<Slot> slots;
+	// cache slot of every page of the file, -1 when it isn't resident
+	std::vector<int> pageSlots;
+	size_t residentCount = 0;
+	uint64_t frame = 0;
+
+	GLuint feedbackFramebuffer = 0;
+	GLuint feedbackRenderbuffers[2] = {};
+	GLuint feedbackBuffers[2] = {};
+	bool feedbackPending[2] = {};
+	int feedbackIndex = 0;
+	int feedbackWidth = 0;
+	int feedbackHeight = 0;
+	GLint viewport[4] = {};
+	GLint previousFramebuffer = 0;
+
+	// pages queued or loaded, not uploaded yet
+	std::unordered_set<uint32_t> pending;
+	std::mutex mutex;
+	std::vector<LoadedPage> loaded;
+	std::unique_ptr<ThreadPool> pool;
+
+	static const char* Magic()
+	{
+		return "LOGLVTX";
+	}
+
+	// the level table must be the one Write() makes: halved sizes, their page counts and contiguous
+	// pages, every page within the file. The indirection and the feedback index with it unchecked
+	static bool ValidLevels(const Header& header, const std::vector<Level>& levels)
+	{
+		if (header.width == 0 || header.height == 0)
+		{
+			return false;
+		}
+		uint64_t pageCount = 0;
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			const Level& level = levels[i];
+			if (level.width != std::max(header.width >> i, 1u) || level.height != std::max(header.height >> i, 1u)
+				|| level.pagesX != ((uint64_t)level.width + header.pageSize - 1) / header.pageSize
+				|| level.pagesY != ((uint64_t)level.height + header.pageSize - 1) / header.pageSize
+				|| level.firstPage != pageCount)
+			{
+				return false;
+			}
+			pageCount += (uint64_t)level.pagesX * level.pagesY;
+		}
+		return pageCount == header.pageCount;
+	}
+
+	static uint64_t DataOffset(uint32_t levelCount)
+	{
+		return (sizeof(Header) + sizeof(Level) * levelCount + 15) & ~(uint64_t)15;
+	}
+
+	static uint64_t PageBytes(const Header& header)
+	{
+		uint64_t paddedSize = header.pageSize + 2 * header.border;
+		return paddedSize * paddedSize * 4;
+	}
+
+	void readPage(uint32_t page, unsigned char* pixels) const
+	{
+		PROFILE_SCOPE("page read");
+		memcpy(pixels, file.getData() + DataOffset(header.levelCount) + page * PageBytes(header), PageBytes(header));
+	}
+
+	void uploadPage(int slot, const unsigned char* pixels)
+	{
+		int paddedSize = getPaddedPageSize();
+		glBindTexture(GL_TEXTURE_2D, cache);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, slot % cacheSlots * paddedSize, slot / cacheSlots * paddedSize, paddedSize, paddedSize, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	}
+
+	// least recently used slot that the current frame doesn't need, -1 if there's none
+	int evict()
+	{
+		int best = -1;
+		for (size_t i = 0; i < slots.size(); i++)
+		{
+			if (slots[i].pinned || (slots[i].page >= 0 && slots[i].lastUse == frame))
+			{
+				continue;
+			}
+			if (slots[i].page < 0)
+			{
+				return (int)i;
+			}
+			if (best < 0 || slots[i].lastUse < slots[best].lastUse)
+			{
+				best = (int)i;
+			}
+		}
+		if (best >= 0)
+		{
+			pageSlots[slots[best].page] = -1;
+			slots[best].page = -1;
+			residentCount--;
+		}
+		return best;
+	}
+
+	// marks the visible pages as used and queues the missing ones
+	void readFeedback(GLuint buffer)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+		const uint16_t* texels = (const uint16_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)feedbackWidth * feedbackHeight * 8, GL_MAP_READ_BIT);
+		std::unordered_set<uint32_t> requested;
+		if (texels)
+		{
+			for (size_t i = 0; i < (size_t)feedbackWidth * feedbackHeight; i++)
+			{
+				const uint16_t* texel = texels + i * 4;
+				// the alpha is 0 where nothing virtual was drawn
+				if (texel[3] == 0 || texel[2] >= levels.size())
+				{
+					continue;
+				}
+				const Level& level = levels[texel[2]];
+				if (texel[0] < level.pagesX && texel[1] < level.pagesY)
+				{
+					requested.insert(level.firstPage + texel[1] * level.pagesX + texel[0]);
+				}
+			}
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		for (uint32_t page : requested)
+		{
+			// the ancestors are kept too, they're the fallback while finer pages load
+			for (int64_t ancestor = page; ancestor >= 0; ancestor = parent((uint32_t)ancestor))
+			{
+				int slot = pageSlots[ancestor];
+				if (slot >= 0)
+				{
+					slots[slot].lastUse = frame;
+				}
+				else if (pending.insert((uint32_t)ancestor).second)
+				{
+					uint32_t missing = (uint32_t)ancestor;
+					pool->submit([this, missing]()
+					{
+						LoadedPage loadedPage;
+						loadedPage.page = missing;
+						loadedPage.pixels.resize(PageBytes(header));
+						// the copy out of the mapping is where the disk is read
+						readPage(missing, loadedPage.pixels.data());
+						std::lock_guard<std::mutex> lock(mutex);
+						loaded.push_back(std::move(loadedPage));
+					});
+				}
+			}
+		}
+	}
+
+	// page of the next level covering a page, -1 for the last level
+	int64_t parent(uint32_t page) const
+	{
+		for (size_t l = 0; l + 1 < levels.size(); l++)
+		{
+			const Level& level = levels[l];
+			if (page < level.firstPage + level.pagesX * level.pagesY)
+			{
+				uint32_t x = (page - level.firstPage) % level.pagesX;
+				uint32_t y = (page - level.firstPage) / level.pagesX;
+				const Level& next = levels[l + 1];
+				return next.firstPage + std::min(y / 2, next.pagesY - 1) * next.pagesX + std::min(x / 2, next.pagesX - 1);
+			}
+		}
+		return -1;
+	}
+
+	// every page points at its slot, or at the slot of its closest resident ancestor
+	void updateIndirection()
+	{
+		size_t layerSize = (size_t)levels[0].pagesX * levels[0].pagesY * 4;
+		glBindTexture(GL_TEXTURE_2D_ARRAY, indirection);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		// the layers are as large as level 0, only the pages of each level are uploaded
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, levels[0].pagesX);
+		for (int l = (int)levels.size() - 1; l >= 0; l--)
+		{
+			const Level& level = levels[l];
+			unsigned char* layer = indirectionData.data() + l * layerSize;
+			for (uint32_t y = 0; y < level.pagesY; y++)
+			{
+				for (uint32_t x = 0; x < level.pagesX; x++)
+				{
+					unsigned char* entry = layer + ((size_t)y * levels[0].pagesX + x) * 4;
+					int slot = pageSlots[level.firstPage + y * level.pagesX + x];
+					if (slot >= 0)
+					{
+						entry[0] = (unsigned char)(slot % cacheSlots);
+						entry[1] = (unsigned char)(slot / cacheSlots);
+						entry[2] = (unsigned char)l;
+						entry[3] = 255;
+					}
+					else
+					{
+						// the last level is always resident, so the parent entry is set
+						const Level& next = levels[l + 1];
+						size_t parent = (size_t)std::min(y / 2, next.pagesY - 1) * levels[0].pagesX + std::min(x / 2, next.pagesX - 1);
+						memcpy(entry, indirectionData.data() + (l + 1) * layerSize + parent * 4, 4);
+					}
+				}
+			}
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, l, level.pagesX, level.pagesY, 1, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, layer);
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+};
+
+#endif // !VIRTUAL_TEXTURE_H
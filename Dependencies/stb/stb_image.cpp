@@ -0,0 +1,7 @@
+#define STB_IMAGE_IMPLEMENTATION
+// Image::Load shrinks stbi_loadf buffers with realloc and frees everything with stbi_image_free,
+// which only match while stb_image allocates with the C runtime
+#if defined(STBI_MALLOC) || defined(STBI_REALLOC) || defined(STBI_FREE)
+#error "TextureLoader.h expects the default stb_image allocator"
+#endif
+#include "stb_image.h"
\ No newline at end of file
@@ -4,6 +4,7 @@
 // opengl includes
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <Context.h>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
@@ -39,42 +40,18 @@ const char* fragmentShaderSource = "#version 330 core\n"
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-int main()
+int main(int argc, char** argv)
 {
-	// glfw :: initialization
-	if (!glfwInit())
+	// create window and context, run with --headless to render offscreen
+	Context context(Context::ParseArgs(argc, argv, { SCR_WIDTH, SCR_HEIGHT, "EBO - press W for wireframe and F for fill" }));
+	if (!context.isValid())
 	{
-		std::cerr << "ERROR::GLFW::INITIALIZATION_FAILED\n";
-	}
-
-	// glfw :: settings
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// create window and context
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "EBO - press W for wireframe and F for fill", NULL, NULL);
-	if (window == NULL)
-	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
 		exit(EXIT_FAILURE);
 	}
-	glfwMakeContextCurrent(window);
 	// set window resize callback
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	context.setFramebufferSizeCallback(framebuffer_size_callback);
 	// kayboard input callback
-	glfwSetKeyCallback(window, input_keyCallback);
-
-	// load GLAD
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
-		exit(EXIT_FAILURE);
-	}
-
-	// set OpenGL Viewport size
-	glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+	context.setKeyCallback(input_keyCallback);
 
 	// status check variables
 	GLint success;
@@ -157,7 +134,7 @@ int main()
 	// set wireframe
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-	while (!glfwWindowShouldClose(window))
+	while (!context.shouldClose())
 	{
 		glClearColor(1.0, 1.0, 1.0, 1.0);
 		glClear(GL_COLOR_BUFFER_BIT);
@@ -169,16 +146,16 @@ int main()
 		// draw the six indices
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		context.swapBuffers();
+		context.pollEvents();
 	}
 
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO);
 	glDeleteProgram(shaderProgram);
 
-	// glfw :: terminate, clearing all previously allocated GLFW resources.
-	glfwTerminate();
+	// terminate, clearing all previously allocated window/context resources.
+	context.terminate();
 
 	std::cout << "LOG::APP::CLOSED_SUCCESS\n";
 	exit(EXIT_SUCCESS); // app closed successfully
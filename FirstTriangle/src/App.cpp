@@ -4,10 +4,11 @@
 // opengl includes
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <Context.h>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void RenderLoop(GLFWwindow* window);
-void Draw(GLFWwindow* window, GLuint shaderProgram, GLuint VAO);
+void RenderLoop(Context& context);
+void Draw(Context& context, GLuint shaderProgram, GLuint VAO);
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // settings
@@ -37,49 +38,24 @@ const char* fragmentShaderSource = "#version 330 core\n"
     "   FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
     "}\0";
 
-int main(void)
+int main(int argc, char** argv)
 {
-    // init glfw
-    if (!glfwInit())
+    // create window and context, run with --headless to render offscreen
+    Context context(Context::ParseArgs(argc, argv, { SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL" }));
+    if (!context.isValid())
     {
-        std::cerr << "Could not load GLFW" << std::endl;
         exit(EXIT_FAILURE);
     }
-
-    // glfw settings
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // create window and context
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        exit(EXIT_FAILURE);
-    }
-    glfwMakeContextCurrent(window);
     // set window resize callback
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    context.setFramebufferSizeCallback(framebuffer_size_callback);
     // kayboard input callback
-    glfwSetKeyCallback(window, input_keyCallback);
-
-    // load GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    // set OpenGL Viewport size
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    context.setKeyCallback(input_keyCallback);
 
     // main loop
-    RenderLoop(window);
+    RenderLoop(context);
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    glfwTerminate();
+    // terminate, clearing all previously allocated window/context resources.
+    context.terminate();
 
     // app closed successfully
     exit(EXIT_SUCCESS);
@@ -91,7 +67,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);    
 }
 
-void RenderLoop(GLFWwindow* window)
+void RenderLoop(Context& context)
 {
     // create Vertex Array Object
     GLuint VAO;
@@ -173,13 +149,13 @@ void RenderLoop(GLFWwindow* window)
     glDeleteShader(fragmentShader);
 
     // render loop
-    while (!glfwWindowShouldClose(window))
+    while (!context.shouldClose())
     {
         // render
-        Draw(window, shaderProgram, VAO);
+        Draw(context, shaderProgram, VAO);
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        glfwPollEvents();
+        // poll IO events (keys pressed/released, mouse moved etc.)
+        context.pollEvents();
     }
 
     glDeleteVertexArrays(1, &VAO);
@@ -187,7 +163,7 @@ void RenderLoop(GLFWwindow* window)
     glDeleteProgram(shaderProgram);
 }
 
-void Draw(GLFWwindow* window, GLuint shaderProgram, GLuint VAO)
+void Draw(Context& context, GLuint shaderProgram, GLuint VAO)
 {
     // clear frame buffer
     glClear(GL_COLOR_BUFFER_BIT);
@@ -199,7 +175,7 @@ void Draw(GLFWwindow* window, GLuint shaderProgram, GLuint VAO)
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
     // swap buffer
-    glfwSwapBuffers(window);
+    context.swapBuffers();
 }
 
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -4,11 +4,13 @@
 // opengl includes
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <Context.h>
 #include <Shader.h>
+#include <ShaderWatcher.h>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void RenderLoop(GLFWwindow* window);
-void Draw(GLFWwindow* window, Shader shader, GLuint VAO);
+void RenderLoop(Context& context);
+void Draw(Context& context, const Shader& shader, UniformHandle theta, GLuint VAO);
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // settings
@@ -26,49 +28,24 @@ const unsigned int indices[] = {  // note that we start from 0!
     0, 1, 2,   // first triangle
 };
 
-int main(void)
+int main(int argc, char** argv)
 {
-    // init glfw
-    if (!glfwInit())
+    // create window and context, run with --headless to render offscreen
+    Context context(Context::ParseArgs(argc, argv, { SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL" }));
+    if (!context.isValid())
     {
-        std::cerr << "Could not load GLFW" << std::endl;
         exit(EXIT_FAILURE);
     }
-
-    // glfw settings
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // create window and context
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        exit(EXIT_FAILURE);
-    }
-    glfwMakeContextCurrent(window);
     // set window resize callback
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    context.setFramebufferSizeCallback(framebuffer_size_callback);
     // kayboard input callback
-    glfwSetKeyCallback(window, input_keyCallback);
-
-    // load GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    // set OpenGL Viewport size
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    context.setKeyCallback(input_keyCallback);
 
     // main loop
-    RenderLoop(window);
+    RenderLoop(context);
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    glfwTerminate();
+    // terminate, clearing all previously allocated window/context resources.
+    context.terminate();
 
     // app closed successfully
     exit(EXIT_SUCCESS);
@@ -80,7 +57,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);    
 }
 
-void RenderLoop(GLFWwindow* window)
+void RenderLoop(Context& context)
 {
     // create Vertex Array Object
     GLuint VAO, VBO, EBO;
@@ -111,21 +88,34 @@ void RenderLoop(GLFWwindow* window)
     GLint success;
     char infoLog[512];
     
-    // create shader
+    // create shader, reusing the program binary of previous runs
+    ShaderCache::SetDirectory("./shadercache");
     Shader shader(
         "./resources/shaders/vert.vs", 
         "./resources/shaders/frag.fs"
     );
 
+    // uniforms updated every frame
+    UniformHandle theta = shader.getUniform("uTheta");
+
+    // recompile the shader when its files are edited
+    ShaderWatcher watcher(shader, "./resources/shaders/vert.vs", "./resources/shaders/frag.fs");
+
     // render loop
 
-    while (!glfwWindowShouldClose(window))
+    while (!context.shouldClose())
     {
+        // swap in the edited shader between frames
+        if (watcher.update())
+        {
+            theta = shader.getUniform("uTheta");
+        }
+
         // render
-        Draw(window, shader, VAO);
+        Draw(context, shader, theta, VAO);
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        glfwPollEvents();
+        // poll IO events (keys pressed/released, mouse moved etc.)
+        context.pollEvents();
     }
 
     glDeleteVertexArrays(1, &VAO);
@@ -134,7 +124,7 @@ void RenderLoop(GLFWwindow* window)
 
 static float val = 0.0;
 
-void Draw(GLFWwindow* window, Shader shader, GLuint VAO)
+void Draw(Context& context, const Shader& shader, UniformHandle theta, GLuint VAO)
 {
     // clear frame buffer
     glClear(GL_COLOR_BUFFER_BIT);
@@ -142,14 +132,14 @@ void Draw(GLFWwindow* window, Shader shader, GLuint VAO)
     glClearColor(0.1, 0.4, 0.5, 1.0);
 
     shader.use();
-    shader.setFloat("uTheta", val);
-    val = glfwGetTime();
+    shader.setFloat(theta, val);
+    val = context.getTime();
 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0);
 
     // swap buffer
-    glfwSwapBuffers(window);
+    context.swapBuffers();
 }
 
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
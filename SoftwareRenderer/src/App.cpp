@@ -0,0 +1,340 @@
+// system includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// rasterizer includes
+#include <SoftwareRasterizer.h>
+#include <TextureLoader.h>
+
+bool DrawScene(SoftwareRasterizer& rasterizer, const std::string& scene);
+bool WriteFrame(const SoftwareRasterizer& rasterizer, const std::string& path);
+void Benchmark(unsigned int threads);
+
+// settings
+const int SCR_WIDTH = 800;
+const int SCR_HEIGHT = 600;
+
+// renders the frame of a sample on the CPU, without window nor GPU, into a ppm file
+// comparable to the one written by the sample with --headless --output;
+// --benchmark measures the triangle throughput of the rasterizer
+//
+// usage: SoftwareRenderer [--threads N] [--size WxH] <FirstTriangle|EBO|Triforce|Textures> <output.ppm>
+//        SoftwareRenderer [--threads N] --benchmark
+int main(int argc, char** argv)
+{
+    // 0: a worker per core
+    unsigned int threads = 0;
+    int width = SCR_WIDTH;
+    int height = SCR_HEIGHT;
+    bool benchmark = false;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+            {
+                std::cout << "ERROR::SOFTWARE_RENDERER::INVALID_SIZE " << argv[i] << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmark = true;
+        }
+        else
+        {
+            arguments.push_back(argv[i]);
+        }
+    }
+
+    if (benchmark)
+    {
+        Benchmark(threads);
+        exit(EXIT_SUCCESS);
+    }
+    if (arguments.size() < 2)
+    {
+        std::cout << "usage: SoftwareRenderer [--threads N] [--size WxH] <FirstTriangle|EBO|Triforce|Textures> <output.ppm>" << std::endl;
+        std::cout << "       SoftwareRenderer [--threads N] --benchmark" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    SoftwareRasterizer rasterizer(width, height, threads);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (!DrawScene(rasterizer, arguments[0]))
+    {
+        exit(EXIT_FAILURE);
+    }
+    double drawTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "LOG::SOFTWARE_RENDERER::RENDERED " << arguments[0] << " " << width << "x" << height << " in " << drawTime
+        << " ms, " << rasterizer.getStatistics().fragments << " fragments, " << rasterizer.getThreadCount() << " threads" << std::endl;
+
+    exit(WriteFrame(rasterizer, arguments[1]) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+// the samples draw in orange on white
+const SoftwareProgram OrangeProgram = {
+    [](const Vec4* attributes, float*) { return Vec4(attributes[0].x, attributes[0].y, attributes[0].z, 1.0f); },
+    [](const SoftwareFragment&) { return Vec4(1.0f, 0.5f, 0.2f, 1.0f); },
+    0
+};
+
+// draws the frame of a sample, with the same buffers and calls
+bool DrawScene(SoftwareRasterizer& rasterizer, const std::string& scene)
+{
+    if (scene == "FirstTriangle")
+    {
+        const float vertices[] = {
+            -0.5f, -0.5f, 0.0f,
+             0.5f, -0.5f, 0.0f,
+             0.0f,  0.5f, 0.0f
+        };
+        GLuint VAO = rasterizer.genVertexArray();
+        GLuint VBO = rasterizer.genBuffer();
+        rasterizer.bindVertexArray(VAO);
+        rasterizer.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        rasterizer.bufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices);
+        rasterizer.vertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+        rasterizer.enableVertexAttribArray(0);
+
+        rasterizer.clearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        rasterizer.clear();
+        rasterizer.useProgram(&OrangeProgram);
+        rasterizer.drawArrays(GL_TRIANGLES, 0, 3);
+        return true;
+    }
+    if (scene == "EBO" || scene == "Triforce")
+    {
+        const float quad[] = {
+             0.5f,  0.5f, 0.0f,  // top right
+             0.5f, -0.5f, 0.0f,  // bottom right
+            -0.5f, -0.5f, 0.0f,  // bottom left
+            -0.5f,  0.5f, 0.0f   // top left
+        };
+        const unsigned int quadIndices[] = {
+            0, 1, 3,
+            1, 2, 3
+        };
+        const float triforce[] = {
+            -0.25f,  -0.25f, 0.0f,
+             0.0f,   -0.25f, 0.0f,
+             0.25f,  -0.25f, 0.0f,
+            -0.125f,  0.0f,  0.0f,
+             0.125f,  0.0f,  0.0f,
+             0.0f,    0.25f, 0.0f
+        };
+        const unsigned int triforceIndices[] = {
+            0, 1, 3,
+            1, 2, 4,
+            3, 4, 5
+        };
+        bool isQuad = scene == "EBO";
+        GLuint VAO = rasterizer.genVertexArray();
+        GLuint VBO = rasterizer.genBuffer();
+        GLuint EBO = rasterizer.genBuffer();
+        rasterizer.bindVertexArray(VAO);
+        rasterizer.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        rasterizer.bufferData(GL_ARRAY_BUFFER, isQuad ? sizeof(quad) : sizeof(triforce), isQuad ? quad : triforce);
+        rasterizer.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        rasterizer.bufferData(GL_ELEMENT_ARRAY_BUFFER, isQuad ? sizeof(quadIndices) : sizeof(triforceIndices), isQuad ? quadIndices : triforceIndices);
+        rasterizer.vertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+        rasterizer.enableVertexAttribArray(0);
+
+        rasterizer.clearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        rasterizer.clear();
+        rasterizer.useProgram(&OrangeProgram);
+        rasterizer.drawElements(GL_TRIANGLES, isQuad ? 6 : 9, GL_UNSIGNED_INT, 0);
+        return true;
+    }
+    if (scene == "Textures")
+    {
+        const float vertices[] = {
+            // positions          // colors           // texture coords
+             0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,   // top right
+             0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,   // bottom right
+            -0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,   // bottom left
+            -0.5f,  0.5f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f    // top left
+        };
+        const unsigned int indices[] = {
+            0, 1, 2,
+            0, 2, 3
+        };
+        Image image = Image::Decode("./resources/textures/container.jpg", 3);
+        if (!image.isValid())
+        {
+            std::cout << "ERROR::SOFTWARE_RENDERER::LOAD_FAILED " << image.getPath() << " " << image.getError() << std::endl;
+            return false;
+        }
+        // default sampler state, mipmaps generated like glGenerateMipmap
+        SoftwareTexture texture;
+        texture.image(image.getWidth(), image.getHeight(), image.getChannels(), image.getPixels());
+        texture.generateMipmap();
+
+        // vCol then texPos
+        SoftwareProgram program = {
+            [](const Vec4* attributes, float* varyings)
+            {
+                varyings[0] = attributes[1].x;
+                varyings[1] = attributes[1].y;
+                varyings[2] = attributes[1].z;
+                varyings[3] = attributes[2].x;
+                varyings[4] = attributes[2].y;
+                return Vec4(attributes[0].x, attributes[0].y, attributes[0].z, 1.0f);
+            },
+            [&texture](const SoftwareFragment& fragment)
+            {
+                return texture.sample(fragment, 3) * Vec4(fragment.varyings[0], fragment.varyings[1], fragment.varyings[2], 1.0f);
+            },
+            5
+        };
+
+        GLuint VAO = rasterizer.genVertexArray();
+        GLuint VBO = rasterizer.genBuffer();
+        GLuint EBO = rasterizer.genBuffer();
+        rasterizer.bindVertexArray(VAO);
+        rasterizer.bindBuffer(GL_ARRAY_BUFFER, VBO);
+        rasterizer.bufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices);
+        rasterizer.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        rasterizer.bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices);
+        rasterizer.vertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 0);
+        rasterizer.enableVertexAttribArray(0);
+        rasterizer.vertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 3 * sizeof(float));
+        rasterizer.enableVertexAttribArray(1);
+        rasterizer.vertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 6 * sizeof(float));
+        rasterizer.enableVertexAttribArray(2);
+
+        rasterizer.clearColor(0.1f, 0.4f, 0.5f, 1.0f);
+        rasterizer.clear();
+        rasterizer.useProgram(&program);
+        rasterizer.drawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        return true;
+    }
+    std::cout << "ERROR::SOFTWARE_RENDERER::UNKNOWN_SCENE " << scene << std::endl;
+    return false;
+}
+
+bool WriteFrame(const SoftwareRasterizer& rasterizer, const std::string& path)
+{
+    std::vector<unsigned char> pixels;
+    rasterizer.readPixels(pixels);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::SOFTWARE_RENDERER::FRAME_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", rasterizer.getWidth(), rasterizer.getHeight());
+    // the rows of the framebuffer start at the bottom, ppm rows at the top
+    size_t rowSize = (size_t)rasterizer.getWidth() * 3;
+    for (int y = rasterizer.getHeight(); y > 0; y--)
+    {
+        fwrite(pixels.data() + (y - 1) * rowSize, 1, rowSize, file);
+    }
+    fclose(file);
+    return true;
+}
+
+// draws batches of random triangles of a few sizes at 1080p, on one thread then on the workers
+void Benchmark(unsigned int threads)
+{
+    const int width = 1920;
+    const int height = 1080;
+    const int count = 100000;
+    // interpolated colors, so the fragment shader reads varyings
+    SoftwareProgram program = {
+        [](const Vec4* attributes, float* varyings)
+        {
+            varyings[0] = attributes[1].x;
+            varyings[1] = attributes[1].y;
+            varyings[2] = attributes[1].z;
+            return Vec4(attributes[0].x, attributes[0].y, 0.0f, 1.0f);
+        },
+        [](const SoftwareFragment& fragment) { return Vec4(fragment.varyings[0], fragment.varyings[1], fragment.varyings[2], 1.0f); },
+        3
+    };
+
+    SoftwareRasterizer single(width, height, 1);
+    SoftwareRasterizer parallel(width, height, threads);
+    std::cout << "LOG::SOFTWARE_RENDERER::BENCHMARK " << width << "x" << height << ", " << count << " triangles per draw, "
+        << parallel.getThreadCount() << " threads" << std::endl;
+    for (float size : { 4.0f, 16.0f, 48.0f })
+    {
+        // position then color, the same triangles every run
+        std::vector<float> vertices;
+        vertices.reserve((size_t)count * 3 * 5);
+        unsigned int seed = 1;
+        auto random = [&seed]()
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) / 16777216.0f;
+        };
+        for (int i = 0; i < count * 3; i++)
+        {
+            if (i % 3 == 0)
+            {
+                vertices.push_back(random() * 2.0f - 1.0f);
+                vertices.push_back(random() * 2.0f - 1.0f);
+            }
+            else
+            {
+                // around the first vertex of the triangle, size pixels away at most
+                size_t first = vertices.size() - (size_t)(i % 3) * 5;
+                vertices.push_back(vertices[first] + (random() * 2.0f - 1.0f) * size * 2.0f / width);
+                vertices.push_back(vertices[first + 1] + (random() * 2.0f - 1.0f) * size * 2.0f / height);
+            }
+            vertices.push_back(random());
+            vertices.push_back(random());
+            vertices.push_back(random());
+        }
+
+        double milliseconds[2];
+        uint64_t fragments = 0;
+        bool identical = true;
+        SoftwareRasterizer* rasterizers[2] = { &single, &parallel };
+        for (int r = 0; r < 2; r++)
+        {
+            SoftwareRasterizer& rasterizer = *rasterizers[r];
+            GLuint VAO = rasterizer.genVertexArray();
+            GLuint VBO = rasterizer.genBuffer();
+            rasterizer.bindVertexArray(VAO);
+            rasterizer.bindBuffer(GL_ARRAY_BUFFER, VBO);
+            rasterizer.bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data());
+            rasterizer.vertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+            rasterizer.enableVertexAttribArray(0);
+            rasterizer.vertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 2 * sizeof(float));
+            rasterizer.enableVertexAttribArray(1);
+            rasterizer.useProgram(&program);
+            rasterizer.clear();
+            // one draw to warm up, the best of three
+            rasterizer.drawArrays(GL_TRIANGLES, 0, count * 3);
+            milliseconds[r] = 1e9;
+            for (int run = 0; run < 3; run++)
+            {
+                rasterizer.clear();
+                rasterizer.resetStatistics();
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                rasterizer.drawArrays(GL_TRIANGLES, 0, count * 3);
+                milliseconds[r] = std::min(milliseconds[r], std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            }
+            fragments = rasterizer.getStatistics().fragments;
+        }
+        // the tiles are drawn in submission order whatever the thread count
+        identical = memcmp(single.getPixels(), parallel.getPixels(), (size_t)width * height * 4) == 0;
+
+        std::cout << "LOG::SOFTWARE_RENDERER::BENCHMARK " << size << " px triangles, " << fragments / count << " fragments each: "
+            << "1 thread " << count / milliseconds[0] / 1000.0 << " Mtris/s " << fragments / milliseconds[0] / 1000.0 << " Mpix/s, "
+            << parallel.getThreadCount() << " threads " << count / milliseconds[1] / 1000.0 << " Mtris/s " << fragments / milliseconds[1] / 1000.0 << " Mpix/s"
+            << (identical ? "" : ", ERROR: the frames differ") << std::endl;
+    }
+}
@@ -0,0 +1,118 @@
+// system includes
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+// opengl includes
+#include <glad/glad.h>
+#include <Context.h>
+#include <Shader.h>
+
+// a Shader owns its program: drawing with it many frames must neither create nor delete
+// programs, moving it hands the program over and the last owner deletes it once.
+// Runs headless, the program calls are counted by wrapping the glad entry points.
+
+const unsigned int FRAMES = 10000;
+
+const char* VERTEX_SOURCE =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "void main() { gl_Position = vec4(aPos, 1.0); }\n";
+const char* FRAGMENT_SOURCE =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "void main() { FragColor = vec4(1.0); }\n";
+
+unsigned int createCount = 0;
+unsigned int deleteCount = 0;
+PFNGLCREATEPROGRAMPROC driverCreateProgram = NULL;
+PFNGLDELETEPROGRAMPROC driverDeleteProgram = NULL;
+
+GLuint APIENTRY CountCreateProgram()
+{
+    createCount++;
+    return driverCreateProgram();
+}
+
+void APIENTRY CountDeleteProgram(GLuint program)
+{
+    deleteCount++;
+    driverDeleteProgram(program);
+}
+
+// same signature as the samples: the shader is used, never copied
+void Draw(const Shader& shader, GLuint VAO)
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    shader.use();
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+bool Check(const char* step, unsigned int creates, unsigned int deletes)
+{
+    if (createCount == creates && deleteCount == deletes)
+    {
+        return true;
+    }
+    std::cout << "ERROR::SHADER_OWNERSHIP::" << step << " expected " << creates << " create and " << deletes << " delete, got "
+        << createCount << " and " << deleteCount << std::endl;
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    ContextSettings settings = Context::ParseArgs(argc, argv, { 64, 64, "ShaderOwnership" });
+    settings.headless = true;
+    Context context(settings);
+    if (!context.isValid())
+    {
+        std::cout << "ERROR::SHADER_OWNERSHIP::NO_CONTEXT" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    driverCreateProgram = glad_glCreateProgram;
+    glad_glCreateProgram = CountCreateProgram;
+    driverDeleteProgram = glad_glDeleteProgram;
+    glad_glDeleteProgram = CountDeleteProgram;
+
+    GLuint VAO, VBO;
+    float vertices[] = { -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.0f, 0.5f, 0.0f };
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    bool success = true;
+    {
+        ShaderSource vertexSource, fragmentSource;
+        vertexSource.appendCopy(VERTEX_SOURCE);
+        fragmentSource.appendCopy(FRAGMENT_SOURCE);
+        Shader shader(vertexSource, fragmentSource);
+        success = success && shader.isLinked();
+
+        for (unsigned int i = 0; i < FRAMES; i++)
+        {
+            Draw(shader, VAO);
+        }
+        glFinish();
+        success = Check("DRAW", 1, 0) && success;
+
+        // the program follows the moves, the moved-from shaders own nothing
+        Shader moved(std::move(shader));
+        Shader assigned;
+        assigned = std::move(moved);
+        Draw(assigned, VAO);
+        success = Check("MOVE", 1, 0) && success;
+    }
+    success = Check("SCOPE_EXIT", 1, 1) && success;
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    std::cout << "LOG::SHADER_OWNERSHIP::" << (success ? "PASSED " : "FAILED ") << FRAMES << " frames, "
+        << createCount << " create, " << deleteCount << " delete" << std::endl;
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,27 @@
+#version 330 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+in vec3 texPos;
+out vec4 FragColor;
+
+#ifdef BINDLESS
+flat in int vTexture;
+// two 64 bit texture handles per element
+layout (std140) uniform BindlessTextures
+{
+    uvec4 handles[1024];
+};
+#else
+uniform sampler2DArray atlas;
+#endif
+
+void main()
+{
+#ifdef BINDLESS
+    uvec4 pair = handles[vTexture >> 1];
+    FragColor = texture(sampler2D((vTexture & 1) == 0 ? pair.xy : pair.zw), texPos.xy);
+#else
+    FragColor = texture(atlas, texPos);
+#endif
+}
\ No newline at end of file
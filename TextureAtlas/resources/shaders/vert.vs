@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTex;
+// per quad: center, atlas region (offset, scale) and layer, or the texture index when bindless
+layout (location = 2) in vec2 aOffset;
+layout (location = 3) in vec4 aRegion;
+layout (location = 4) in float aLayer;
+
+out vec3 texPos;
+#ifdef BINDLESS
+flat out int vTexture;
+#endif
+
+uniform float uTheta = 0.0;
+
+void main()
+{
+    // remap the quad coordinates into the image region of the atlas
+    texPos = vec3(aRegion.xy + aTex * aRegion.zw, aLayer);
+#ifdef BINDLESS
+    vTexture = int(aLayer);
+#endif
+    float wave = sin(uTheta * 2.0 + aOffset.x * 6.0) * 0.01;
+    gl_Position = vec4(aPos + aOffset + vec2(0.0, wave), 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+// system includes
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// opengl includes
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <Context.h>
+#include <Shader.h>
+#include <ShaderWatcher.h>
+#include <BindlessTextures.h>
+#include <TextureAtlas.h>
+#include <TextureLoader.h>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void RenderLoop(Context& context);
+void Draw(Context& context, const Shader& shader, UniformHandle theta, GLuint VAO, GLsizei quads);
+void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+// quads on screen, each one showing one of the atlas images
+const int COLUMNS = 40;
+const int ROWS = 30;
+// procedural images packed next to the JPEGs
+const int GENERATED_IMAGES = 48;
+
+// data
+float vertices[] = {
+    // positions      // texture coords
+     0.5f,  0.5f,     1.0f, 1.0f,   // top right
+     0.5f, -0.5f,     1.0f, 0.0f,   // bottom right
+    -0.5f, -0.5f,     0.0f, 0.0f,   // bottom left
+    -0.5f,  0.5f,     0.0f, 1.0f    // top left
+};
+const unsigned int indices[] = {  // note that we start from 0!
+    0, 1, 2,   // first triangle
+    0, 2, 3
+};
+
+// per quad attributes, read once per instance
+struct Quad
+{
+    float offset[2];
+    float region[4];
+    float layer;
+};
+
+int main(int argc, char** argv)
+{
+    // create window and context, run with --headless to render offscreen
+    Context context(Context::ParseArgs(argc, argv, { SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL" }));
+    if (!context.isValid())
+    {
+        exit(EXIT_FAILURE);
+    }
+    // set window resize callback
+    context.setFramebufferSizeCallback(framebuffer_size_callback);
+    // kayboard input callback
+    context.setKeyCallback(input_keyCallback);
+
+    // main loop
+    RenderLoop(context);
+
+    // terminate, clearing all previously allocated window/context resources.
+    context.terminate();
+
+    // app closed successfully
+    exit(EXIT_SUCCESS);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // update
+    glViewport(0, 0, width, height);
+}
+
+// checkerboard of a random size and two random colors
+std::vector<unsigned char> GenerateImage(unsigned int& seed, int& width, int& height)
+{
+    auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    width = 16 + random() % 112;
+    height = 16 + random() % 112;
+    int cell = 4 + random() % 12;
+    unsigned char colors[2][3];
+    for (int i = 0; i < 6; i++)
+    {
+        colors[i / 3][i % 3] = (unsigned char)random();
+    }
+    std::vector<unsigned char> pixels((size_t)width * height * 3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const unsigned char* color = colors[(x / cell + y / cell) % 2];
+            memcpy(&pixels[((size_t)y * width + x) * 3], color, 3);
+        }
+    }
+    return pixels;
+}
+
+void RenderLoop(Context& context)
+{
+    // decode the JPEGs on the loader threads while the procedural images are generated
+    TextureLoader loader;
+    std::vector<std::future<Image>> images = loader.loadAll({ "./resources/textures/container.jpg", "./resources/textures/wall.jpg" });
+
+    // with ARB_bindless_texture every image keeps its own texture, the shader picks its handle;
+    // otherwise every image goes to one texture array: a single bind for all the quads either way
+    std::unique_ptr<BindlessTextures> bindless;
+    if (BindlessTextures::IsSupported())
+    {
+        bindless.reset(new BindlessTextures());
+    }
+    else
+    {
+        std::cout << "LOG::BINDLESS_TEXTURES::UNSUPPORTED packing the images in a texture array" << std::endl;
+    }
+    TextureAtlas atlas;
+    std::vector<size_t> handles;
+    unsigned int seed = 7;
+    for (int i = 0; i < GENERATED_IMAGES; i++)
+    {
+        int width, height;
+        std::vector<unsigned char> pixels = GenerateImage(seed, width, height);
+        handles.push_back(bindless ? bindless->add(pixels.data(), width, height, 3) : atlas.add(pixels.data(), width, height, 3));
+    }
+    for (std::future<Image>& future : images)
+    {
+        Image image = future.get();
+        if (!image.isValid())
+        {
+            std::cout << "ERROR::TEXTURE::LOAD_FAILED " << image.getPath() << " " << image.getError() << std::endl;
+            continue;
+        }
+        handles.push_back(bindless ? bindless->add(image) : atlas.add(image));
+    }
+    if (!bindless)
+    {
+        atlas.build();
+    }
+
+    // create shader, the BINDLESS variant reads the handles from a uniform block
+    std::vector<std::string> defines;
+    if (bindless)
+    {
+        defines.push_back("BINDLESS");
+    }
+    Shader shader(
+        "./resources/shaders/vert.vs",
+        "./resources/shaders/frag.fs",
+        defines
+    );
+
+    // quads in a grid, the image of each one is picked by its region of the atlas or its handle
+    std::vector<Quad> quads;
+    for (int row = 0; row < ROWS; row++)
+    {
+        for (int column = 0; column < COLUMNS; column++)
+        {
+            size_t handle = handles[(row * COLUMNS + column) % handles.size()];
+            AtlasRegion region = bindless ? AtlasRegion{ (int)handle, { 0.0f, 0.0f }, { 1.0f, 1.0f } } : atlas.getRegion(handle);
+            Quad quad;
+            quad.offset[0] = -1.0f + (column + 0.5f) * 2.0f / COLUMNS;
+            quad.offset[1] = -1.0f + (row + 0.5f) * 2.0f / ROWS;
+            quad.region[0] = region.offset[0];
+            quad.region[1] = region.offset[1];
+            quad.region[2] = region.scale[0];
+            quad.region[3] = region.scale[1];
+            quad.layer = (float)region.layer;
+            quads.push_back(quad);
+        }
+    }
+    // the unit quad shrinks to a grid cell, with a small gap
+    for (int i = 0; i < 4; i++)
+    {
+        vertices[i * 4 + 0] *= 2.0f / COLUMNS * 0.9f;
+        vertices[i * 4 + 1] *= 2.0f / ROWS * 0.9f;
+    }
+
+    // create Vertex Array Object
+    GLuint VAO, VBO, EBO, instanceVBO;
+    glGenVertexArrays(1, &VAO);
+    // create Vertex Buffer in the GPU
+    glGenBuffers(1, &VBO);
+    // create Element Object Buffer
+    glGenBuffers(1, &EBO);
+    // create the per quad buffer
+    glGenBuffers(1, &instanceVBO);
+
+    // bind VAO :: everything after that is related to this VAO ::
+    glBindVertexArray(VAO);
+    // bind VBO
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // copy data inside the VBO
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // setup EBO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    // setup Vertex Attrib pointers to pass POSITION DATA to the GPU
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // set attrib pointer per location 1 for texPosition
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // per quad attributes advance once per instance
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, quads.size() * sizeof(Quad), quads.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)offsetof(Quad, offset));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)offsetof(Quad, region));
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Quad), (void*)offsetof(Quad, layer));
+    for (GLuint location = 2; location <= 4; location++)
+    {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    // uniforms updated every frame
+    UniformHandle theta = shader.getUniform("uTheta");
+
+    // the handles are read from binding point 0
+    if (bindless)
+    {
+        glUniformBlockBinding(shader.getID(), glGetUniformBlockIndex(shader.getID(), "BindlessTextures"), 0);
+    }
+
+    // recompile the shader when its files are edited
+    ShaderWatcher watcher(shader, "./resources/shaders/vert.vs", "./resources/shaders/frag.fs", defines);
+
+    // render loop
+
+    while (!context.shouldClose())
+    {
+        // swap in the edited shader between frames
+        if (watcher.update())
+        {
+            theta = shader.getUniform("uTheta");
+            if (bindless)
+            {
+                glUniformBlockBinding(shader.getID(), glGetUniformBlockIndex(shader.getID(), "BindlessTextures"), 0);
+            }
+        }
+
+        // one bind for every quad: the handle buffer, whose textures have to be resident, or the atlas
+        if (bindless)
+        {
+            for (size_t handle : handles)
+            {
+                bindless->use(handle);
+            }
+            bindless->bind(0);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.getTexture());
+        }
+
+        // render
+        Draw(context, shader, theta, VAO, (GLsizei)quads.size());
+        // the textures unused for a while stop being resident
+        if (bindless)
+        {
+            bindless->update();
+        }
+
+        // poll IO events (keys pressed/released, mouse moved etc.)
+        context.pollEvents();
+    }
+
+    // cleanup
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &instanceVBO);
+}
+
+void Draw(Context& context, const Shader& shader, UniformHandle theta, GLuint VAO, GLsizei quads)
+{
+    // clear frame buffer
+    glClear(GL_COLOR_BUFFER_BIT);
+    // set frame buffer color
+    glClearColor(0.1, 0.4, 0.5, 1.0);
+
+    shader.use();
+    shader.setFloat(theta, context.getTime());
+
+    // every quad in a single draw call
+    glBindVertexArray(VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, quads);
+
+    // swap buffer
+    context.swapBuffers();
+}
+
+void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    // input
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+    {
+        glfwSetWindowShouldClose(window, true);
+    }
+
+    // switch between wireframe and fill
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+    if (key == GLFW_KEY_W && action == GLFW_PRESS)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+}
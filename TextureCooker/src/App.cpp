@@ -0,0 +1,242 @@
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// texture includes
+#include <BlockCompressor.h>
+#include <CookedTexture.h>
+#include <CpuProfiler.h>
+#include <MipGenerator.h>
+#include <TextureLoader.h>
+#include <VirtualTexture.h>
+
+void Benchmark(ThreadPool& pool);
+
+// converts images to .ctex files with their whole mip chain, so the samples
+// map them at startup instead of decoding JPEGs and generating mipmaps;
+// with --virtual the chain is cut into pages streamed by VirtualTexture (.vtex)
+//
+// usage: TextureCooker [--flip] [--linear] [--filter box|kaiser] [--format auto|raw|bc1|bc3] <output directory> <image>...
+//        TextureCooker --virtual [--page-size N] [--flip] [--linear] [--filter box|kaiser] <output directory> <image>...
+//        TextureCooker --benchmark
+// --profile trace.json records the decoding, mipmaps and compression of every thread
+int main(int argc, char** argv)
+{
+    bool flip = false;
+    bool benchmark = false;
+    // virtual textures: RGBA pages of pageSize texels plus a border
+    bool virtualTexture = false;
+    int pageSize = 128;
+    std::string profile;
+    // auto: BC1 for RGB images, BC3 for RGBA ones, the others are stored as they are
+    std::string format = "auto";
+    // images are sRGB unless told otherwise: their mipmaps are averaged in linear space
+    MipSettings settings;
+    settings.srgb = true;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--flip") == 0)
+        {
+            flip = true;
+        }
+        else if (strcmp(argv[i], "--linear") == 0)
+        {
+            settings.srgb = false;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            settings.filter = strcmp(argv[++i], "kaiser") == 0 ? MipFilter::Kaiser : MipFilter::Box;
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            format = argv[++i];
+        }
+        else if (strcmp(argv[i], "--virtual") == 0)
+        {
+            virtualTexture = true;
+        }
+        else if (strcmp(argv[i], "--page-size") == 0 && i + 1 < argc)
+        {
+            pageSize = std::max(8, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmark = true;
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            profile = argv[++i];
+        }
+        else
+        {
+            arguments.push_back(argv[i]);
+        }
+    }
+
+    if (!profile.empty())
+    {
+        CpuProfiler::Start();
+        PROFILE_THREAD("main");
+    }
+
+    // mipmaps are filtered a band of rows per worker
+    ThreadPool pool;
+    settings.pool = &pool;
+    if (benchmark)
+    {
+        Benchmark(pool);
+        exit(EXIT_SUCCESS);
+    }
+    if (arguments.size() < 2)
+    {
+        std::cout << "usage: TextureCooker [--flip] [--linear] [--filter box|kaiser] [--format auto|raw|bc1|bc3] <output directory> <image>..." << std::endl;
+        std::cout << "       TextureCooker --virtual [--page-size N] [--flip] [--linear] [--filter box|kaiser] <output directory> <image>..." << std::endl;
+        std::cout << "       TextureCooker --benchmark" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::filesystem::path output(arguments[0]);
+    std::error_code error;
+    std::filesystem::create_directories(output, error);
+
+    // decode every image at once on the loader threads
+    TextureLoader loader;
+    std::vector<std::future<Image>> images = loader.loadAll(std::vector<std::string>(arguments.begin() + 1, arguments.end()), virtualTexture ? 4 : 0, flip);
+
+    bool success = true;
+    for (std::future<Image>& future : images)
+    {
+        Image image = future.get();
+        if (!image.isValid())
+        {
+            std::cout << "ERROR::TEXTURE_COOKER::LOAD_FAILED " << image.getPath() << " " << image.getError() << std::endl;
+            success = false;
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<MipLevel> levels = MipGenerator::Generate(image.getPixels(), image.getWidth(), image.getHeight(), image.getChannels(), settings);
+        double mipTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (virtualTexture)
+        {
+            std::filesystem::path path = output / std::filesystem::path(image.getPath()).stem();
+            path += ".vtex";
+            if (!VirtualTexture::Write(path.string(), levels, pageSize))
+            {
+                std::cout << "ERROR::TEXTURE_COOKER::WRITE_FAILED " << path.string() << std::endl;
+                success = false;
+                continue;
+            }
+            std::cout << "LOG::TEXTURE_COOKER::COOKED " << path.string() << " " << image.getWidth() << "x" << image.getHeight()
+                << ", " << pageSize << " texel pages, decoded in " << image.getDecodeTime() << " ms, mipmaps in " << mipTime << " ms" << std::endl;
+            continue;
+        }
+
+        BlockFormat blockFormat = BlockFormat::Uncompressed;
+        if (format == "bc1" || (format == "auto" && image.getChannels() == 3))
+        {
+            blockFormat = BlockFormat::BC1;
+        }
+        else if (format == "bc3" || (format == "auto" && image.getChannels() == 4))
+        {
+            blockFormat = BlockFormat::BC3;
+        }
+        if (blockFormat != BlockFormat::Uncompressed && image.getChannels() < 3)
+        {
+            std::cout << "LOG::TEXTURE_COOKER::NOT_COMPRESSED " << image.getPath() << " has less than 3 channels" << std::endl;
+            blockFormat = BlockFormat::Uncompressed;
+        }
+
+        start = std::chrono::steady_clock::now();
+        if (blockFormat != BlockFormat::Uncompressed)
+        {
+            for (MipLevel& level : levels)
+            {
+                level.pixels = BlockCompressor::Encode(level.pixels.data(), level.width, level.height, image.getChannels(), blockFormat, &pool);
+            }
+        }
+        double compressTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::filesystem::path path = output / std::filesystem::path(image.getPath()).stem();
+        path += ".ctex";
+        if (!CookedTexture::Write(path.string(), levels, image.getChannels(), blockFormat))
+        {
+            std::cout << "ERROR::TEXTURE_COOKER::WRITE_FAILED " << path.string() << std::endl;
+            success = false;
+            continue;
+        }
+        std::cout << "LOG::TEXTURE_COOKER::COOKED " << path.string() << " " << image.getWidth() << "x" << image.getHeight()
+            << "x" << image.getChannels() << ", " << levels.size() << " levels, decoded in " << image.getDecodeTime()
+            << " ms, mipmaps in " << mipTime << " ms";
+        if (blockFormat != BlockFormat::Uncompressed)
+        {
+            std::cout << ", " << (blockFormat == BlockFormat::BC1 ? "BC1" : "BC3") << " in " << compressTime << " ms";
+        }
+        std::cout << std::endl;
+    }
+
+    if (!profile.empty())
+    {
+        CpuProfiler::Stop();
+        CpuProfiler::Print();
+        CpuProfiler::WriteTrace(profile);
+    }
+    exit(success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+// times the mip chain of a 4K RGBA image with the scalar reference, the SIMD kernels and the workers
+void Benchmark(ThreadPool& pool)
+{
+    const int size = 4096;
+    const int channels = 4;
+    std::vector<unsigned char> pixels((size_t)size * size * channels);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        // gradients with some noise, so the filters have work to do
+        seed = seed * 1664525u + 1013904223u;
+        pixels[i] = (unsigned char)((i / channels % size) / 32 + (i / channels / size) / 32 + (seed >> 28));
+    }
+
+    std::cout << "LOG::TEXTURE_COOKER::BENCHMARK " << size << "x" << size << "x" << channels << ", "
+        << MipGenerator::InstructionSet() << ", " << pool.getCount() << " workers" << std::endl;
+    for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+    {
+        for (bool srgb : { false, true })
+        {
+            MipSettings settings;
+            settings.filter = filter;
+            settings.srgb = srgb;
+
+            std::vector<MipLevel> reference;
+            double times[3];
+            for (int run = 0; run < 3; run++)
+            {
+                settings.simd = run > 0;
+                settings.pool = run > 1 ? &pool : NULL;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                std::vector<MipLevel> levels = MipGenerator::Generate(pixels.data(), size, size, channels, settings);
+                times[run] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (run == 0)
+                {
+                    reference = std::move(levels);
+                }
+                else if (levels.back().pixels != reference.back().pixels || levels[1].pixels != reference[1].pixels)
+                {
+                    std::cout << "ERROR::TEXTURE_COOKER::BENCHMARK_MISMATCH" << std::endl;
+                }
+            }
+            std::cout << (filter == MipFilter::Box ? "box    " : "kaiser ") << (srgb ? "srgb   " : "linear ")
+                << "scalar " << times[0] << " ms, simd " << times[1] << " ms (" << times[0] / times[1] << "x), simd + workers "
+                << times[2] << " ms (" << times[0] / times[2] << "x)" << std::endl;
+        }
+    }
+}
@@ -4,12 +4,16 @@
 // opengl includes
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <Context.h>
 #include <Shader.h>
-#include "stb_image.h"
+#include <ShaderWatcher.h>
+#include <CookedTexture.h>
+#include <GpuMemory.h>
+#include <TextureStreamer.h>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void RenderLoop(GLFWwindow* window);
-void Draw(GLFWwindow* window, Shader shader, GLuint VAO);
+void RenderLoop(Context& context);
+void Draw(Context& context, const Shader& shader, UniformHandle theta, GLuint VAO);
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // settings
@@ -29,49 +33,24 @@ const unsigned int indices[] = {  // note that we start from 0!
     0, 2, 3
 };
 
-int main(void)
+int main(int argc, char** argv)
 {
-    // init glfw
-    if (!glfwInit())
+    // create window and context, run with --headless to render offscreen
+    Context context(Context::ParseArgs(argc, argv, { SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL" }));
+    if (!context.isValid())
     {
-        std::cerr << "Could not load GLFW" << std::endl;
         exit(EXIT_FAILURE);
     }
-
-    // glfw settings
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // create window and context
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        exit(EXIT_FAILURE);
-    }
-    glfwMakeContextCurrent(window);
     // set window resize callback
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    context.setFramebufferSizeCallback(framebuffer_size_callback);
     // kayboard input callback
-    glfwSetKeyCallback(window, input_keyCallback);
-
-    // load GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    // set OpenGL Viewport size
-    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+    context.setKeyCallback(input_keyCallback);
 
     // main loop
-    RenderLoop(window);
+    RenderLoop(context);
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    glfwTerminate();
+    // terminate, clearing all previously allocated window/context resources.
+    context.terminate();
 
     // app closed successfully
     exit(EXIT_SUCCESS);
@@ -83,29 +62,23 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);    
 }
 
-void RenderLoop(GLFWwindow* window)
+void RenderLoop(Context& context)
 {
-    // generating a texture
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    // loading texture source
-    int width, height, nChannels;
-    const char* path = "./resources/textures/container.jpg";
-    unsigned char* data = stbi_load(path, &width, &height, &nChannels, 0);
-    if (data)
-    {
-        // creating the texture from the source
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        // creating the mipmap for the texture
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cout << "Failed to load Texture" << std::endl;
-    }
-
+    // a cooked texture is mapped and uploaded with its mipmaps as it is,
+    // otherwise the JPEG is decoded on the streamer threads and uploaded a part per frame
+    TextureStreamer streamer;
+    GLuint texture = CookedTexture::Upload("./resources/textures/container.ctex");
+    // HDR and 16 bit images keep their precision (half floats / 16 bit channels), JPEGs stay 8 bit
+    size_t container = texture ? 0 : streamer.load("./resources/textures/container.jpg", Image::UPLOAD_CHANNELS, false, false, true);
+
+    // create shader, reusing the program binary of previous runs.
+    // The driver compiles it while the texture is decoded, it is waited for on first use
+    ShaderCache::SetDirectory("./shadercache");
+    Shader shader(
+        "./resources/shaders/vert.vs",
+        "./resources/shaders/frag.fs",
+        ShaderCompile::Deferred
+    );
 
     // create Vertex Array Object
     GLuint VAO, VBO, EBO;
@@ -135,38 +108,66 @@ void RenderLoop(GLFWwindow* window)
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
+    // account the video memory of the buffers and the texture, textures over budget lose their top mips
+    GpuMemory memory;
+    memory.addBuffer(VBO);
+    memory.addBuffer(EBO);
+    size_t managed = texture ? memory.addTexture(texture) : 0;
+    memory.print();
+
     // status check variables
     GLint success;
     char infoLog[512];
 
 
-    // create shader
-    Shader shader(
-        "./resources/shaders/vert.vs",
-        "./resources/shaders/frag.fs"
-    );
+    // uniforms updated every frame
+    UniformHandle theta = shader.getUniform("uTheta");
 
+    // recompile the shader when its files are edited
+    ShaderWatcher watcher(shader, "./resources/shaders/vert.vs", "./resources/shaders/frag.fs");
 
     // render loop
 
-    while (!glfwWindowShouldClose(window))
+    while (!context.shouldClose())
     {
+        // swap in the edited shader between frames
+        if (watcher.update())
+        {
+            theta = shader.getUniform("uTheta");
+        }
+
+        // upload the staged texture rows, the texture is usable once complete
+        if (!texture)
+        {
+            streamer.update();
+            texture = streamer.getTexture(container);
+            if (texture)
+            {
+                managed = memory.addTexture(texture);
+            }
+        }
+        // the registry may have replaced the texture with a smaller one
+        glBindTexture(GL_TEXTURE_2D, texture ? memory.use(managed) : 0);
+
         // render
-        Draw(window, shader, VAO);
+        Draw(context, shader, theta, VAO);
+        memory.update();
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        glfwPollEvents();
+        // poll IO events (keys pressed/released, mouse moved etc.)
+        context.pollEvents();
     }
 
-    // cleanup
-    glDeleteTextures(1, &texture);
+    // cleanup, the texture is deleted by the registry
     glDeleteVertexArrays(1, &VAO);
+    memory.removeBuffer(VBO);
+    memory.removeBuffer(EBO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
 }
 
 static float val = 0.0;
 
-void Draw(GLFWwindow* window, Shader shader, GLuint VAO)
+void Draw(Context& context, const Shader& shader, UniformHandle theta, GLuint VAO)
 {
     // clear frame buffer
     glClear(GL_COLOR_BUFFER_BIT);
@@ -174,14 +175,14 @@ void Draw(GLFWwindow* window, Shader shader, GLuint VAO)
     glClearColor(0.1, 0.4, 0.5, 1.0);
 
     shader.use();
-    shader.setFloat("uTheta", val);
-    val = glfwGetTime();
+    shader.setFloat(theta, val);
+    val = context.getTime();
 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
     // swap buffer
-    glfwSwapBuffers(window);
+    context.swapBuffers();
 }
 
 void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
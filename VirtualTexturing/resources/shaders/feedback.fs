@@ -0,0 +1,15 @@
+#version 330 core
+in vec2 texPos;
+out uvec4 Feedback;
+
+#include "virtual.glsl"
+
+void main()
+{
+   // the cleared texels request no page
+   if (any(lessThan(texPos, vec2(0.0))) || any(greaterThan(texPos, vec2(1.0))))
+   {
+      discard;
+   }
+   Feedback = VirtualFeedback(texPos);
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 330 core
+in vec2 texPos;
+out vec4 FragColor;
+
+#include "virtual.glsl"
+
+void main()
+{
+   // nothing around the image
+   if (any(lessThan(texPos, vec2(0.0))) || any(greaterThan(texPos, vec2(1.0))))
+   {
+      discard;
+   }
+   FragColor = VirtualSample(texPos);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoord;
+
+out vec2 texPos;
+
+uniform float uZoom;
+
+void main()
+{
+   gl_Position = vec4(aPos, 0.0, 1.0);
+   // zoom toward a point of the image, the finer levels stream in as it gets closer
+   texPos = vec2(0.37, 0.61) + (aTexCoord - 0.5) * vec2(4.0 / 3.0, 1.0) * uZoom;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+// virtual texture lookups, the uniforms are set by VirtualTexture::setUniforms()
+uniform sampler2D uVirtualCache;
+uniform usampler2DArray uVirtualIndirection;
+uniform ivec2 uVirtualSize;
+uniform int uVirtualPageSize;
+uniform int uVirtualBorder;
+uniform int uVirtualLevels;
+uniform float uVirtualCacheSize;
+uniform float uVirtualBias;
+
+// finest level whose texels aren't smaller than a pixel
+int VirtualLevel(vec2 uv)
+{
+    vec2 dx = dFdx(uv * vec2(uVirtualSize));
+    vec2 dy = dFdy(uv * vec2(uVirtualSize));
+    float level = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + uVirtualBias;
+    return int(clamp(floor(level), 0.0, float(uVirtualLevels - 1)));
+}
+
+// size of a level in texels and in pages
+ivec2 VirtualLevelSize(int level)
+{
+    return max(ivec2(1), uVirtualSize >> level);
+}
+
+ivec2 VirtualPage(vec2 uv, int level)
+{
+    ivec2 size = VirtualLevelSize(level);
+    ivec2 pages = (size + uVirtualPageSize - 1) / uVirtualPageSize;
+    ivec2 texel = ivec2(clamp(uv, 0.0, 1.0) * vec2(size));
+    return min(texel / uVirtualPageSize, pages - 1);
+}
+
+// page id written by the feedback pass: x, y, level and a flag telling it's set
+uvec4 VirtualFeedback(vec2 uv)
+{
+    int level = VirtualLevel(uv);
+    return uvec4(uvec2(VirtualPage(uv, level)), uint(level), 1u);
+}
+
+// samples the finest resident page covering uv
+vec4 VirtualSample(vec2 uv)
+{
+    int level = VirtualLevel(uv);
+    ivec2 page = VirtualPage(uv, level);
+    // slot in the cache and level of the page, or of the ancestor standing in for it
+    uvec4 entry = texelFetch(uVirtualIndirection, ivec3(page, level), 0);
+    int resident = int(entry.z);
+    ivec2 size = VirtualLevelSize(resident);
+    ivec2 pages = (size + uVirtualPageSize - 1) / uVirtualPageSize;
+    ivec2 ancestor = min(page >> (resident - level), pages - 1);
+    // texel inside the page, the border covers the filter footprint across its edges
+    vec2 local = clamp(uv, 0.0, 1.0) * vec2(size) - vec2(ancestor * uVirtualPageSize);
+    local = clamp(local, vec2(0.5 - float(uVirtualBorder)), vec2(float(uVirtualPageSize + uVirtualBorder) - 0.5));
+    vec2 slot = vec2(entry.xy) * float(uVirtualPageSize + 2 * uVirtualBorder) + float(uVirtualBorder);
+    return texture(uVirtualCache, (slot + local) / uVirtualCacheSize);
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+// system includes
+#include <cmath>
+#include <iostream>
+
+// opengl includes
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <Context.h>
+#include <GpuProfiler.h>
+#include <Shader.h>
+#include <ShaderWatcher.h>
+#include <VirtualTexture.h>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void RenderLoop(Context& context);
+void DrawFeedback(Context& context, const Shader& shader, VirtualTexture& texture, GLuint VAO);
+void Draw(Context& context, const Shader& shader, const VirtualTexture& texture, GLuint VAO);
+void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+// the page cache holds CACHE_SLOTS x CACHE_SLOTS pages, whatever the size of the image
+const int CACHE_SLOTS = 6;
+// texture units of the page cache and of the indirection
+const GLuint CACHE_UNIT = 0;
+const GLuint INDIRECTION_UNIT = 1;
+
+// data
+float vertices[] = {
+    // positions      // texture coords
+     1.0f,  1.0f,     1.0f, 1.0f,   // top right
+     1.0f, -1.0f,     1.0f, 0.0f,   // bottom right
+    -1.0f, -1.0f,     0.0f, 0.0f,   // bottom left
+    -1.0f,  1.0f,     0.0f, 1.0f    // top left
+};
+const unsigned int indices[] = {  // note that we start from 0!
+    0, 1, 2,   // first triangle
+    0, 2, 3
+};
+
+int main(int argc, char** argv)
+{
+    // create window and context, run with --headless to render offscreen
+    Context context(Context::ParseArgs(argc, argv, { SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL" }));
+    if (!context.isValid())
+    {
+        exit(EXIT_FAILURE);
+    }
+    // set window resize callback
+    context.setFramebufferSizeCallback(framebuffer_size_callback);
+    // kayboard input callback
+    context.setKeyCallback(input_keyCallback);
+
+    // main loop
+    RenderLoop(context);
+
+    // terminate, clearing all previously allocated window/context resources.
+    context.terminate();
+
+    // app closed successfully
+    exit(EXIT_SUCCESS);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    // update
+    glViewport(0, 0, width, height);
+}
+
+// zooms from the whole image to a few texels per page, over and over
+float Zoom(const Context& context)
+{
+    return std::exp2(4.0f - std::fmod((float)context.getTime(), 12.0f) * 0.5f);
+}
+
+void RenderLoop(Context& context)
+{
+    // the image was cut into pages by the TextureCooker: only the visible ones are loaded
+    VirtualTexture texture("./resources/textures/wall.vtex", CACHE_SLOTS);
+    if (!texture.isValid())
+    {
+        return;
+    }
+
+    // the scene is drawn twice: at low resolution writing the pages it needs, then sampling them
+    Shader feedbackShader(
+        "./resources/shaders/vert.vs",
+        "./resources/shaders/feedback.fs"
+    );
+    Shader shader(
+        "./resources/shaders/vert.vs",
+        "./resources/shaders/frag.fs"
+    );
+
+    // create Vertex Array Object
+    GLuint VAO, VBO, EBO;
+    glGenVertexArrays(1, &VAO);
+    // create Vertex Buffer in the GPU
+    glGenBuffers(1, &VBO);
+    // create Element Object Buffer
+    glGenBuffers(1, &EBO);
+
+    // bind VAO :: everything after that is related to this VAO ::
+    glBindVertexArray(VAO);
+    // bind VBO
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    // copy data inside the VBO
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // setup EBO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    // setup Vertex Attrib pointers to pass POSITION DATA to the GPU
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    // set attrib pointer per location 1 for texPosition
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // recompile the shaders when their files are edited
+    ShaderWatcher feedbackWatcher(feedbackShader, "./resources/shaders/vert.vs", "./resources/shaders/feedback.fs");
+    ShaderWatcher watcher(shader, "./resources/shaders/vert.vs", "./resources/shaders/frag.fs");
+
+    std::cout << "LOG::VIRTUAL_TEXTURE::OPENED " << texture.getWidth() << "x" << texture.getHeight() << ", "
+        << texture.getLevelCount() << " levels of " << texture.getPageSize() << " texel pages, "
+        << CACHE_SLOTS * CACHE_SLOTS << " pages cached" << std::endl;
+
+    // render loop
+
+    while (!context.shouldClose())
+    {
+        // swap in the edited shaders between frames
+        feedbackWatcher.update();
+        watcher.update();
+
+        // request the pages of this frame, upload the ones loaded since the last
+        DrawFeedback(context, feedbackShader, texture, VAO);
+        {
+            GpuScope scope("upload");
+            texture.update();
+        }
+
+        // render
+        Draw(context, shader, texture, VAO);
+
+        // poll IO events (keys pressed/released, mouse moved etc.)
+        context.pollEvents();
+    }
+    std::cout << "LOG::VIRTUAL_TEXTURE::RESIDENT " << texture.getResidentCount() << " pages" << std::endl;
+
+    // cleanup
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+void DrawFeedback(Context& context, const Shader& shader, VirtualTexture& texture, GLuint VAO)
+{
+    // GPU time of the pass, with --profile
+    GpuScope scope("feedback");
+    texture.beginFeedback();
+
+    shader.use();
+    texture.setUniforms(shader.getID(), CACHE_UNIT, INDIRECTION_UNIT, true);
+    shader.setFloat("uZoom", Zoom(context));
+
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+    texture.endFeedback();
+}
+
+void Draw(Context& context, const Shader& shader, const VirtualTexture& texture, GLuint VAO)
+{
+    {
+        GpuScope scope("draw");
+        // clear frame buffer
+        glClear(GL_COLOR_BUFFER_BIT);
+        // set frame buffer color
+        glClearColor(0.1, 0.4, 0.5, 1.0);
+
+        shader.use();
+        texture.bind(CACHE_UNIT, INDIRECTION_UNIT);
+        texture.setUniforms(shader.getID(), CACHE_UNIT, INDIRECTION_UNIT, false);
+        shader.setFloat("uZoom", Zoom(context));
+
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    }
+
+    // swap buffer
+    context.swapBuffers();
+}
+
+void input_keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    // input
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+    {
+        glfwSetWindowShouldClose(window, true);
+    }
+
+    // switch between wireframe and fill
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+    if (key == GLFW_KEY_W && action == GLFW_PRESS)
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+}